@@ -0,0 +1,44 @@
+#include "alloc-log.h"
+
+void alloc_log_init(struct alloc_log* log) {
+    log->allocated.segments = NULL;
+    log->allocated.size = 0;
+    log->allocated.capacity = 0;
+    log->freed.segments = NULL;
+    log->freed.size = 0;
+    log->freed.capacity = 0;
+}
+
+bool alloc_log_add_alloc(struct alloc_log* log, void* segment) {
+    return segment_array_add(&log->allocated, segment);
+}
+
+bool alloc_log_add_free(struct alloc_log* log, void* segment) {
+    return segment_array_add(&log->freed, segment);
+}
+
+bool segment_array_add(struct segment_array* array, void* segment) {
+    if (unlikely(array->size == array->capacity)) {
+        size_t capacity = array->capacity == 0 ? ALLOC_LOG_INITIAL_CAPACITY : 2 * array->capacity;
+        void** segments = (void**) realloc(array->segments, capacity * sizeof(void*));
+        if (unlikely(!segments)) {
+            return false;
+        }
+        array->segments = segments;
+        array->capacity = capacity;
+    }
+
+    array->segments[array->size++] = segment;
+    return true;
+}
+
+void alloc_log_cleanup(struct alloc_log* log) {
+    log->allocated.size = 0; // Keep the capacities for the next transaction
+    log->freed.size = 0;
+}
+
+void alloc_log_destroy(struct alloc_log* log) {
+    free(log->allocated.segments);
+    free(log->freed.segments);
+    alloc_log_init(log);
+}
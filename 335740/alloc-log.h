@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "macros.h"
+
+#define ALLOC_LOG_INITIAL_CAPACITY 16
+
+/**
+ * @brief Growable array of segments.
+ */
+struct segment_array {
+    void** segments;
+    size_t size;
+    size_t capacity;
+};
+
+/**
+ * @brief Segments allocated and freed by a transaction: the allocated ones are recycled if it aborts, and the freed
+ * ones retired only if it commits (kept across transactions of a thread).
+ */
+struct alloc_log {
+    struct segment_array allocated;
+    struct segment_array freed;
+};
+
+void alloc_log_init(struct alloc_log* log);
+
+bool alloc_log_add_alloc(struct alloc_log* log, void* segment);
+
+bool alloc_log_add_free(struct alloc_log* log, void* segment);
+
+bool segment_array_add(struct segment_array* array, void* segment); // private fn
+
+void alloc_log_cleanup(struct alloc_log* log);
+
+void alloc_log_destroy(struct alloc_log* log);
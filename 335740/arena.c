@@ -0,0 +1,77 @@
+#define _GNU_SOURCE // MAP_ANONYMOUS and MAP_NORESERVE
+
+#include "arena.h"
+
+/** Reserve the address range of an arena, with chunks large enough for the first segment.
+ * @param arena         Arena to initialize
+ * @param first_size    Size of the first segment, which must fit in the data part of one chunk
+ * @param grain_shift   Log2 of the bytes covered by one lock (word or cache line)
+ * @param align         Alignment of every allocation (power of 2)
+ * @return Whether the range could be reserved
+**/
+bool arena_init(struct arena* arena, size_t first_size, int grain_shift, size_t align) {
+    arena->grain_shift = grain_shift;
+    arena->align = align > CACHE_LINE_SIZE ? align : CACHE_LINE_SIZE;
+    arena->size = (size_t) 1 << (ARENA_STRIPE_BITS + grain_shift);
+
+    size_t page = arena->align > ARENA_PAGE_SIZE ? arena->align : ARENA_PAGE_SIZE;
+    for (arena->chunk_shift = ARENA_MIN_CHUNK_SHIFT; true; arena->chunk_shift++) {
+        size_t chunk = (size_t) 1 << arena->chunk_shift;
+        if (unlikely(chunk > arena->size)) {
+            return false;
+        }
+        // One lock of sizeof(struct versioned_spinlock_t) bytes per grain of the rest of the chunk
+        size_t lock_size = sizeof(struct versioned_spinlock_t);
+        size_t num_locks = (chunk + ((size_t) 1 << grain_shift) + lock_size - 1) / (((size_t) 1 << grain_shift) + lock_size);
+        arena->header = (num_locks * lock_size + page - 1) & ~(page - 1);
+        if (arena->header < chunk && chunk - arena->header >= first_size) {
+            break;
+        }
+    }
+
+    size_t chunk = (size_t) 1 << arena->chunk_shift;
+    arena->mapping_size = arena->size + chunk; // Room to align the base on a chunk
+    arena->mapping = mmap(NULL, arena->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (unlikely(arena->mapping == MAP_FAILED)) {
+        return false;
+    }
+    arena->base = ((uintptr_t) arena->mapping + chunk - 1) & ~(uintptr_t) (chunk - 1);
+    atomic_init(&arena->next, arena->header);
+    return true;
+}
+
+/** Hand out a zeroed range of an arena, within the data part of a single chunk.
+ * @param arena Arena
+ * @param size  Size of the range (in bytes)
+ * @return Start of the range, NULL if it does not fit in a chunk or the arena is exhausted
+**/
+void* arena_alloc(struct arena* arena, size_t size) {
+    size_t chunk = (size_t) 1 << arena->chunk_shift;
+    size = (size + arena->align - 1) & ~(arena->align - 1);
+    if (unlikely(size > chunk - arena->header)) {
+        return NULL;
+    }
+
+    uintptr_t start = atomic_load_explicit(&arena->next, memory_order_relaxed);
+    uintptr_t end;
+    do {
+        uintptr_t offset = start;
+        if ((offset & (chunk - 1)) < arena->header) { // Skip the locks at the start of the chunk
+            offset = (offset & ~(uintptr_t) (chunk - 1)) + arena->header;
+        }
+        if ((offset & (chunk - 1)) + size > chunk) { // Move on to the data part of the next chunk
+            offset = (offset | (chunk - 1)) + 1 + arena->header;
+        }
+        end = offset + size;
+        if (unlikely(end > arena->size)) {
+            return NULL;
+        }
+        if (atomic_compare_exchange_weak(&arena->next, &start, end)) {
+            return (void*) (arena->base + offset);
+        }
+    } while (true);
+}
+
+void arena_cleanup(struct arena* arena) {
+    munmap(arena->mapping, arena->mapping_size);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "macros.h"
+#include "versioned-spinlock.h"
+
+#define ARENA_MIN_CHUNK_SHIFT 21 // Log2 of the smallest chunk (2 MiB)
+#define ARENA_STRIPE_BITS 31     // Stripes of the whole arena must fit in an int
+#define ARENA_PAGE_SIZE 4096
+
+/**
+ * @brief Reserved address range carved into aligned chunks, every chunk starting with the versioned locks of the
+ * other bytes of the chunk, so that the lock of a word is found by offset arithmetic next to the word.
+ * Pages are only backed by memory once touched, so untouched locks are zero (unlocked, version 0) for free.
+ */
+struct arena {
+    void* mapping;          // Whole mapping, for munmap
+    size_t mapping_size;    // Size of the mapping (in bytes)
+    uintptr_t base;         // Start of the first chunk (aligned on a chunk)
+    size_t size;            // Size of the usable range (in bytes), a multiple of the chunk size
+    int chunk_shift;        // Log2 of the chunk size
+    size_t header;          // Bytes at the start of every chunk holding the locks of the rest of the chunk
+    int grain_shift;        // Log2 of the bytes covered by one lock
+    size_t align;           // Alignment of every allocation (in bytes)
+    _Atomic uintptr_t next; // Offset (from base) of the first byte never handed out
+};
+
+bool arena_init(struct arena* arena, size_t first_size, int grain_shift, size_t align);
+
+void* arena_alloc(struct arena* arena, size_t size);
+
+void arena_cleanup(struct arena* arena);
@@ -0,0 +1,60 @@
+#include "config.h"
+
+static const char* const lock_layout_names[NUM_LOCK_LAYOUTS] = { "table", "word", "line" };
+static const char* const huge_pages_names[NUM_HUGE_PAGES] = { "off", "thp", "hugetlb" };
+static const char* const numa_placement_names[NUM_NUMA_PLACEMENTS] = { "off", "interleave", "first-touch" };
+static const char* const engine_names[NUM_ENGINES] = { "tl2", "mv", "etl" };
+static const char* const clock_scheme_names[NUM_CLOCK_SCHEMES] = { "gv1", "gv4", "gv5", "gv6", "tlc" };
+static const char* const contention_policy_names[NUM_CONTENTION_POLICIES] = { "spin", "backoff", "karma", "timestamp", "polka" };
+
+void config_init(struct config* config) {
+    config->lock_table_bits = (int) config_env_long(CONFIG_ENV_LOCK_TABLE_BITS, 0, 3, 30);
+    config->lock_table_padded = config_env_long(CONFIG_ENV_LOCK_TABLE_PADDED, 0, 0, 1) != 0;
+    config->lock_layout = (enum lock_layout) config_env_choice(CONFIG_ENV_LOCK_LAYOUT, lock_layout_names, NUM_LOCK_LAYOUTS, LOCK_LAYOUT_TABLE);
+    config->huge_pages = (enum huge_pages) config_env_choice(CONFIG_ENV_HUGE_PAGES, huge_pages_names, NUM_HUGE_PAGES, HUGE_PAGES_OFF);
+    config->numa_placement = (enum numa_placement) config_env_choice(CONFIG_ENV_NUMA, numa_placement_names, NUM_NUMA_PLACEMENTS, NUMA_PLACEMENT_OFF);
+    config->engine = (enum engine) config_env_choice(CONFIG_ENV_ENGINE, engine_names, NUM_ENGINES, ENGINE_TL2);
+    config->clock_scheme = (enum clock_scheme) config_env_choice(CONFIG_ENV_CLOCK, clock_scheme_names, NUM_CLOCK_SCHEMES, CONFIG_DEFAULT_CLOCK);
+    config->contention_policy = (enum contention_policy) config_env_choice(CONFIG_ENV_CONTENTION, contention_policy_names, NUM_CONTENTION_POLICIES, CONTENTION_SPIN);
+    config->irrevocable_after = (int) config_env_long(CONFIG_ENV_IRREVOCABLE_AFTER, 0, 0, 1000000);
+    config->reclaim = config_env_long(CONFIG_ENV_RECLAIM, 1, 0, 1) != 0;
+    config->stats_dump = config_env_long(CONFIG_ENV_STATS_DUMP, 0, 0, 1) != 0;
+    config->profile_period = (int) config_env_long(CONFIG_ENV_PROFILE_PERIOD, 1, 1, 1000000);
+    config->profile_top = (int) config_env_long(CONFIG_ENV_PROFILE_TOP, 10, 1, 1000);
+    if (config->engine == ENGINE_MULTI_VERSION && (config->clock_scheme == CLOCK_GV5 || config->clock_scheme == CLOCK_GV6)) {
+        // Snapshot reads never move the clock, so commits must do it or a snapshot could miss an earlier commit
+        config->clock_scheme = CLOCK_GV4;
+    }
+    if (config->engine == ENGINE_MULTI_VERSION) {
+        // Version chains are indexed by stripe, which the arena layouts number up to 2^31
+        config->lock_layout = LOCK_LAYOUT_TABLE;
+    }
+}
+
+long config_env_long(const char* name, long default_value, long min_value, long max_value) {
+    const char* text = getenv(name);
+    if (text == NULL || *text == '\0') {
+        return default_value;
+    }
+
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (*end != '\0' || value < min_value || value > max_value) { // Ignore malformed or out of range settings
+        return default_value;
+    }
+    return value;
+}
+
+int config_env_choice(const char* name, const char* const* choices, int num_choices, int default_value) {
+    const char* text = getenv(name);
+    if (text == NULL) {
+        return default_value;
+    }
+
+    for (int i = 0; i < num_choices; i++) {
+        if (strcmp(text, choices[i]) == 0) {
+            return i;
+        }
+    }
+    return default_value; // Ignore unknown settings
+}
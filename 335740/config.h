@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+
+#define CONFIG_ENV_LOCK_TABLE_BITS "TM_LOCK_TABLE_BITS"
+#define CONFIG_ENV_LOCK_TABLE_PADDED "TM_LOCK_TABLE_PADDED"
+#define CONFIG_ENV_LOCK_LAYOUT "TM_LOCK_LAYOUT"
+#define CONFIG_ENV_HUGE_PAGES "TM_HUGE_PAGES"
+#define CONFIG_ENV_NUMA "TM_NUMA"
+#define CONFIG_ENV_ENGINE "TM_ENGINE"
+#define CONFIG_ENV_CLOCK "TM_CLOCK"
+#define CONFIG_ENV_CONTENTION "TM_CONTENTION"
+#define CONFIG_ENV_IRREVOCABLE_AFTER "TM_IRREVOCABLE_AFTER"
+#define CONFIG_ENV_RECLAIM "TM_RECLAIM"
+#define CONFIG_ENV_STATS_DUMP "TM_STATS_DUMP"
+#define CONFIG_ENV_PROFILE_PERIOD "TM_PROFILE_PERIOD"
+#define CONFIG_ENV_PROFILE_TOP "TM_PROFILE_TOP"
+
+#ifndef CONFIG_DEFAULT_CLOCK
+    #define CONFIG_DEFAULT_CLOCK CLOCK_GV1 // Build with e.g. -DCONFIG_DEFAULT_CLOCK=CLOCK_GV5 to change the default scheme
+#endif
+
+/**
+ * @brief Placement of the versioned locks of the shared words.
+ */
+enum lock_layout {
+    LOCK_LAYOUT_TABLE, // One table of stripes, words hashed into it by address (default)
+    LOCK_LAYOUT_WORD,  // One lock per word, at the start of the arena chunk holding the word
+    LOCK_LAYOUT_LINE,  // One lock per cache line, at the start of the arena chunk holding the line
+    NUM_LOCK_LAYOUTS
+};
+
+/**
+ * @brief Pages backing the segments and the lock table.
+ */
+enum huge_pages {
+    HUGE_PAGES_OFF,         // Heap memory (default)
+    HUGE_PAGES_TRANSPARENT, // Mapped memory, advised to be backed by transparent huge pages
+    HUGE_PAGES_EXPLICIT,    // Mapped from the huge page pool, transparent huge pages when the pool is too small
+    NUM_HUGE_PAGES
+};
+
+/**
+ * @brief Placement of the segments and of the lock table on the NUMA nodes.
+ */
+enum numa_placement {
+    NUMA_PLACEMENT_OFF,         // Heap memory, zeroed by the thread creating the region (default)
+    NUMA_PLACEMENT_INTERLEAVE,  // Pages spread round-robin over every allowed node
+    NUMA_PLACEMENT_FIRST_TOUCH, // Pages left untouched until the first thread writing them, which gets them on its node
+    NUM_NUMA_PLACEMENTS
+};
+
+/**
+ * @brief Algorithm used to run the transactions of a region.
+ */
+enum engine {
+    ENGINE_TL2,            // Transactional Locking II (default)
+    ENGINE_MULTI_VERSION,  // TL2 keeping old versions, so that read-only transactions never abort
+    ENGINE_ENCOUNTER_TIME, // Encounter-time locking: stripes locked at write time, words written in place with an undo log
+    NUM_ENGINES
+};
+
+/**
+ * @brief Scheme of the global version clock, trading commit contention on the clock for spurious read aborts.
+ */
+enum clock_scheme {
+    CLOCK_GV1, // One fetch-and-add per commit (default)
+    CLOCK_GV4, // One compare-and-swap per commit, commits that fail it share the write version of the winner
+    CLOCK_GV5, // Commits never write the clock, readers move it when they meet a newer version
+    CLOCK_GV6, // GV4 on a random fraction of the commits, GV5 on the others
+    CLOCK_TLC, // One clock per thread, written by its commits only, the global time being the largest of them
+    NUM_CLOCK_SCHEMES
+};
+
+/**
+ * @brief Policy deciding how long a transaction waits for a locked stripe and backs off after an abort.
+ */
+enum contention_policy {
+    CONTENTION_SPIN,      // Wait a few rounds for a locked stripe, retry at once after an abort (default)
+    CONTENTION_BACKOFF,   // Wait a few rounds for a locked stripe, randomized exponential back-off after an abort
+    CONTENTION_KARMA,     // Wait longer for a locked stripe the more work was done, aborted attempts included
+    CONTENTION_TIMESTAMP, // Wait for a locked stripe as long as it takes if older than its owner
+    CONTENTION_POLKA,     // Karma with exponentially longer rounds, and randomized exponential back-off after an abort
+    NUM_CONTENTION_POLICIES
+};
+
+/**
+ * @brief Tunables of a shared memory region, read from the environment when the region is created.
+ */
+struct config {
+    int lock_table_bits;    // Log2 of the number of lock stripes (0 to size the table from the first segment)
+    bool lock_table_padded; // Whether every lock stripe gets a cache line of its own
+    enum lock_layout lock_layout; // Placement of the versioned locks
+    enum huge_pages huge_pages; // Pages backing the segments and the lock table
+    enum numa_placement numa_placement; // Placement of the segments and of the lock table on the NUMA nodes
+    enum engine engine;     // Algorithm used to run the transactions
+    enum clock_scheme clock_scheme; // Scheme of the global version clock
+    enum contention_policy contention_policy; // Policy of the contention manager
+    int irrevocable_after;  // Consecutive aborts after which a transaction runs irrevocably (0 for never)
+    bool reclaim;           // Whether freed segments are returned once no running transaction can read them (kept until destruction otherwise)
+    bool stats_dump;        // Whether the statistics are printed when the region is destroyed (built with -DTM_STATS only)
+    int profile_period;     // One conflict in this many is sampled by the profiler (built with -DTM_PROFILE only)
+    int profile_top;        // Hottest stripes and words reported by the profiler
+};
+
+void config_init(struct config* config);
+
+long config_env_long(const char* name, long default_value, long min_value, long max_value); // private fn
+
+int config_env_choice(const char* name, const char* const* choices, int num_choices, int default_value); // private fn
@@ -0,0 +1,111 @@
+#include "contention-manager.h"
+
+static struct contention_priority priorities[THREAD_ID_MAX + 1]; // Published priorities, indexed by thread id
+static _Thread_local struct contention_history history = { 0 };
+
+/** Start an attempt of a transaction, backing off first if the previous attempt aborted.
+ * @param policy Contention policy
+**/
+void contention_begin(enum contention_policy policy) {
+    // A rolled back attempt failed the reads of the transactions that saw its stripes, which would fail its retry in
+    // turn if they all retried at once, so it backs off whatever the policy
+    if (history.aborts > 0 && (policy == CONTENTION_BACKOFF || policy == CONTENTION_POLKA || history.rolled_back)) {
+        unsigned shift = history.aborts < CONTENTION_BACKOFF_MAX_SHIFT ? history.aborts : CONTENTION_BACKOFF_MAX_SHIFT;
+        contention_pause((unsigned) (contention_random(&history) & ((UINT64_C(1) << shift) - 1)) * CONTENTION_BACKOFF_UNIT);
+    }
+
+    switch (policy) {
+    case CONTENTION_POLKA:
+    case CONTENTION_KARMA:
+        atomic_store_explicit(&priorities[thread_id_get()].priority, history.karma, memory_order_relaxed);
+        break;
+    case CONTENTION_TIMESTAMP:
+        if (history.timestamp == 0) { // Keep the time of the first attempt, so that retries grow older
+            history.timestamp = __rdtsc();
+        }
+        atomic_store_explicit(&priorities[thread_id_get()].priority, UINT64_MAX - history.timestamp, memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+}
+
+/** Decide whether to wait one more round for a stripe locked by another transaction, or to give up (and abort).
+ * Locks are only held by committing transactions, which release them shortly and cannot be aborted,
+ * so the priorities only decide how long a transaction is worth waiting for its enemy.
+ * @param policy    Contention policy
+ * @param owner     Thread id of the lock owner
+ * @param round     Number of rounds already waited for this lock
+ * @param work      Work (accesses) of the current attempt
+ * @return Whether to try again, after having waited
+**/
+bool contention_wait(enum contention_policy policy, uint64_t owner, unsigned round, size_t work) {
+    uint64_t budget = CONTENTION_SPIN_ROUNDS;
+    if (policy == CONTENTION_KARMA || policy == CONTENTION_POLKA) { // Wait longer the more work would be lost compared to the enemy
+        uint64_t priority = history.karma + work;
+        uint64_t enemy = atomic_load_explicit(&priorities[owner].priority, memory_order_relaxed);
+        if (priority > enemy) {
+            budget += priority - enemy;
+        }
+    }
+    else if (policy == CONTENTION_TIMESTAMP) { // Older transactions wait as long as it takes, younger ones give up
+        uint64_t enemy = atomic_load_explicit(&priorities[owner].priority, memory_order_relaxed);
+        if (UINT64_MAX - history.timestamp > enemy) {
+            budget = CONTENTION_MAX_ROUNDS;
+        }
+    }
+    if (round >= budget || round >= CONTENTION_MAX_ROUNDS) {
+        return false;
+    }
+
+    if (policy == CONTENTION_POLKA) { // Exponentially longer rounds
+        unsigned shift = round < CONTENTION_BACKOFF_MAX_SHIFT ? round : CONTENTION_BACKOFF_MAX_SHIFT;
+        contention_pause(CONTENTION_ROUND_PAUSES << shift);
+    }
+    else {
+        contention_pause(CONTENTION_ROUND_PAUSES);
+    }
+    return true;
+}
+
+/** Record an aborted attempt.
+ * @param work          Work (accesses) of the aborted attempt
+ * @param rolled_back   Whether the attempt released stripes it wrote in place, with newer versions
+**/
+void contention_abort(size_t work, bool rolled_back) {
+    history.aborts++;
+    history.karma += work;
+    history.rolled_back = rolled_back;
+}
+
+/** Record a committed attempt, which ends the transaction and resets its history.
+**/
+void contention_commit(void) {
+    history.aborts = 0;
+    history.karma = 0;
+    history.timestamp = 0;
+    history.rolled_back = false;
+}
+
+/** Get the number of consecutive aborts of the current transaction of the thread.
+ * @return Number of aborts since the last commit
+**/
+unsigned contention_aborts(void) {
+    return history.aborts;
+}
+
+uint64_t contention_random(struct contention_history* history) {
+    if (unlikely(history->seed == 0)) {
+        history->seed = (uint32_t) thread_id_get() * 2654435761u + 1;
+    }
+    history->seed ^= history->seed << 13;
+    history->seed ^= history->seed >> 17;
+    history->seed ^= history->seed << 5;
+    return history->seed;
+}
+
+void contention_pause(unsigned pauses) {
+    for (unsigned i = 0; i < pauses; i++) {
+        _mm_pause();
+    }
+}
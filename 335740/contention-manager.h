@@ -0,0 +1,50 @@
+#pragma once
+
+#include <emmintrin.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+
+#include "config.h"
+#include "macros.h"
+#include "thread-id.h"
+
+#define CONTENTION_SPIN_ROUNDS 4        // Rounds a conflicting transaction waits before giving up, without priorities
+#define CONTENTION_MAX_ROUNDS 256       // Rounds a conflicting transaction waits at most, whatever the priorities
+#define CONTENTION_ROUND_PAUSES 4       // Pauses in one round of waiting
+#define CONTENTION_BACKOFF_UNIT 16      // Pauses in one unit of back-off after an abort
+#define CONTENTION_BACKOFF_MAX_SHIFT 10 // Log2 of the largest number of back-off units
+
+/**
+ * @brief Priority of a thread's running transaction, alone on its cache line so that enemies can read it.
+ */
+struct contention_priority {
+    _Atomic uint64_t priority;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Abort history of a thread, driving the contention policy.
+ */
+struct contention_history {
+    unsigned aborts;       // Consecutive aborts of the current transaction
+    uint64_t karma;        // Work (accesses) of the aborted attempts of the current transaction
+    uint64_t timestamp;    // Time of the first attempt of the current transaction
+    uint32_t seed;         // State of the xorshift generator randomizing back-off
+    bool rolled_back;      // Whether the last attempt released stripes it wrote in place, with newer versions
+};
+
+void contention_begin(enum contention_policy policy);
+
+bool contention_wait(enum contention_policy policy, uint64_t owner, unsigned round, size_t work);
+
+void contention_abort(size_t work, bool rolled_back);
+
+void contention_commit(void);
+
+unsigned contention_aborts(void);
+
+uint64_t contention_random(struct contention_history* history); // private fn
+
+void contention_pause(unsigned pauses); // private fn
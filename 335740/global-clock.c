@@ -0,0 +1,116 @@
+#include "global-clock.h"
+
+static _Thread_local uint32_t gv6_seed = 0; // State of the xorshift generator choosing which GV6 commits increment
+
+bool global_clock_init(struct global_clock* clock, enum clock_scheme scheme) {
+    atomic_store(&clock->time, 0);
+    clock->scheme = scheme;
+    clock->thread_clocks = NULL;
+    if (scheme == CLOCK_TLC) {
+        clock->thread_clocks = (struct thread_clock*) aligned_alloc(CACHE_LINE_SIZE, (THREAD_ID_MAX + 1) * sizeof(struct thread_clock));
+        if (unlikely(!clock->thread_clocks)) {
+            return false;
+        }
+        for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+            atomic_store(&clock->thread_clocks[i].time, 0);
+        }
+    }
+    return true;
+}
+
+/** Sample the clock, to be used as a read version.
+ * @param clock Global clock
+ * @return Every write version of the commits that locked their stripes before the call is at most this
+**/
+uint64_t global_clock_sample(struct global_clock* clock) {
+    if (likely(clock->scheme != CLOCK_TLC)) {
+        return atomic_load(&clock->time);
+    }
+
+    // A thread stores its write version after locking and before releasing, so the largest
+    // thread clock covers every commit that finished locking before it was read.
+    uint64_t time = atomic_load(&clock->thread_clocks[THREAD_ID_OVERFLOW].time);
+    size_t high_water = thread_id_high_water();
+    for (size_t i = 0; i < high_water; i++) {
+        uint64_t thread_time = atomic_load(&clock->thread_clocks[i].time);
+        if (thread_time > time) {
+            time = thread_time;
+        }
+    }
+    return time;
+}
+
+/** Get the write version of a commit, once all its stripes are locked.
+ * @param clock Global clock
+ * @param floor Largest version the locked stripes had, which the write version must exceed
+ * @return Write version, shared with concurrent commits unless the scheme is GV1
+**/
+uint64_t global_clock_commit(struct global_clock* clock, uint64_t floor) {
+    uint64_t time;
+    switch (clock->scheme) {
+    case CLOCK_GV1:
+        return atomic_fetch_add_explicit(&clock->time, 1, memory_order_relaxed) + 1;
+    case CLOCK_GV6:
+        if (unlikely(gv6_seed == 0)) {
+            gv6_seed = (uint32_t) thread_id_get() * 2654435761u + 1;
+        }
+        gv6_seed ^= gv6_seed << 13;
+        gv6_seed ^= gv6_seed >> 17;
+        gv6_seed ^= gv6_seed << 5;
+        if (gv6_seed % GV6_INCREMENT_PERIOD != 0) {
+            goto gv5;
+        }
+        // fall through
+    case CLOCK_GV4:
+        // Pass on failure: whoever made the clock move did it on our behalf too
+        time = atomic_load(&clock->time);
+        if (atomic_compare_exchange_strong(&clock->time, &time, time + 1)) {
+            time++;
+        }
+        if (unlikely(time <= floor)) { // The write version must change every overwritten stripe
+            time = global_clock_raise(&clock->time, floor + 1);
+        }
+        return time;
+    case CLOCK_GV5:
+    gv5:
+        // Do not increment: readers move the clock when they meet a version past it
+        time = atomic_load(&clock->time) + 1;
+        return time > floor ? time : floor + 1;
+    case CLOCK_TLC: {
+        time = global_clock_sample(clock) + 1;
+        if (time <= floor) {
+            time = floor + 1;
+        }
+        int id = thread_id_get();
+        if (likely(id != THREAD_ID_OVERFLOW)) { // Only this thread writes its clock
+            atomic_store(&clock->thread_clocks[id].time, time);
+        }
+        else {
+            global_clock_raise(&clock->thread_clocks[id].time, time);
+        }
+        return time;
+    }
+    default:
+        abort();
+    }
+}
+
+/** Make the clock cover a version found on a stripe, so that sampling it again allows reading that stripe (GV5 and GV6).
+ * @param clock     Global clock
+ * @param version   Version of an unlocked stripe
+**/
+void global_clock_advance(struct global_clock* clock, uint64_t version) {
+    if (clock->scheme == CLOCK_GV5 || clock->scheme == CLOCK_GV6) {
+        global_clock_raise(&clock->time, version);
+    }
+}
+
+void global_clock_cleanup(struct global_clock* clock) {
+    free(clock->thread_clocks);
+}
+
+uint64_t global_clock_raise(_Atomic uint64_t* time, uint64_t version) {
+    uint64_t current = atomic_load(time);
+    while (current < version && !atomic_compare_exchange_weak(time, &current, version));
+    return current < version ? version : current;
+}
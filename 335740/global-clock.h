@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "macros.h"
+#include "thread-id.h"
+
+#define GV6_INCREMENT_PERIOD 32 // GV6 increments the clock on about one commit in this many
+
+/**
+ * @brief Clock of one thread (thread-local clock scheme), alone on its cache line.
+ */
+struct thread_clock {
+    _Atomic uint64_t time;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Global version clock, giving read versions to transactions and write versions to commits.
+ */
+struct global_clock {
+    _Atomic uint64_t time;
+    enum clock_scheme scheme;
+    struct thread_clock* thread_clocks; // One per thread id, the last one shared by overflow threads (thread-local scheme only)
+};
+
+bool global_clock_init(struct global_clock* clock, enum clock_scheme scheme);
+
+uint64_t global_clock_sample(struct global_clock* clock);
+
+uint64_t global_clock_commit(struct global_clock* clock, uint64_t floor);
+
+void global_clock_advance(struct global_clock* clock, uint64_t version);
+
+/** Tell whether a write version right after the read version proves that no other transaction committed in between.
+ * @param clock Global clock
+ * @return Whether write versions are unique
+**/
+static inline bool global_clock_unique(const struct global_clock* clock) {
+    return clock->scheme == CLOCK_GV1;
+}
+
+void global_clock_cleanup(struct global_clock* clock);
+
+uint64_t global_clock_raise(_Atomic uint64_t* time, uint64_t version); // private fn
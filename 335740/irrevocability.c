@@ -0,0 +1,68 @@
+#include "irrevocability.h"
+
+void irrevocability_init(struct irrevocability* irrevocability) {
+    atomic_store(&irrevocability->token, false);
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        atomic_store(&irrevocability->flags[i].committing, 0);
+    }
+}
+
+/** Take the token, then wait for the commits that started before to finish.
+ * @param irrevocability Irrevocability token of the region
+**/
+void irrevocability_acquire(struct irrevocability* irrevocability) {
+    unsigned pauses = 0;
+    bool free = false;
+    while (!atomic_compare_exchange_weak(&irrevocability->token, &free, true)) {
+        free = false;
+        irrevocability_wait(&pauses);
+    }
+
+    size_t high_water = thread_id_high_water(); // Threads given an id later see the token before their first commit
+    for (size_t i = 0; i < high_water; i++) {
+        while (atomic_load(&irrevocability->flags[i].committing) != 0) {
+            irrevocability_wait(&pauses);
+        }
+    }
+    while (atomic_load(&irrevocability->flags[THREAD_ID_OVERFLOW].committing) != 0) {
+        irrevocability_wait(&pauses);
+    }
+}
+
+void irrevocability_release(struct irrevocability* irrevocability) {
+    atomic_store_explicit(&irrevocability->token, false, memory_order_release);
+}
+
+/** Announce a commit, waiting for the irrevocable transaction (if any) to end first.
+ * @param irrevocability Irrevocability token of the region
+**/
+void irrevocability_enter_commit(struct irrevocability* irrevocability) {
+    _Atomic uint64_t* committing = &irrevocability->flags[thread_id_get()].committing;
+    unsigned pauses = 0;
+    while (true) {
+        // Announcing before checking the token (both sequentially consistent) guarantees that
+        // either we see the token, or its holder sees our announcement and waits for us.
+        atomic_fetch_add(committing, 1);
+        if (likely(!atomic_load(&irrevocability->token))) {
+            return;
+        }
+        atomic_fetch_sub(committing, 1);
+        while (atomic_load_explicit(&irrevocability->token, memory_order_relaxed)) {
+            irrevocability_wait(&pauses);
+        }
+    }
+}
+
+void irrevocability_leave_commit(struct irrevocability* irrevocability) {
+    atomic_fetch_sub_explicit(&irrevocability->flags[thread_id_get()].committing, 1, memory_order_release);
+}
+
+void irrevocability_wait(unsigned* pauses) {
+    if (*pauses < IRREVOCABILITY_SPIN_PAUSES) {
+        _mm_pause();
+        (*pauses)++;
+    }
+    else {
+        sched_yield(); // The irrevocable transaction may be long, let it run
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <sched.h>
+#include <emmintrin.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macros.h"
+#include "thread-id.h"
+
+#define IRREVOCABILITY_SPIN_PAUSES 64 // Pauses spent waiting before yielding the processor
+
+/**
+ * @brief Flag telling whether a thread is committing, alone on its cache line.
+ */
+struct commit_flag {
+    _Atomic uint64_t committing; // A count for the slot shared by overflow threads, 0 or 1 for the others
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Token held by the only irrevocable transaction, during which no other transaction commits.
+ */
+struct irrevocability {
+    _Atomic bool token;
+    struct commit_flag flags[THREAD_ID_MAX + 1]; // Indexed by thread id
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+void irrevocability_init(struct irrevocability* irrevocability);
+
+void irrevocability_acquire(struct irrevocability* irrevocability);
+
+void irrevocability_release(struct irrevocability* irrevocability);
+
+void irrevocability_enter_commit(struct irrevocability* irrevocability);
+
+void irrevocability_leave_commit(struct irrevocability* irrevocability);
+
+void irrevocability_wait(unsigned* pauses); // private fn
@@ -0,0 +1,113 @@
+#include "lock-set.h"
+
+static int lock_set_compare(const void* a, const void* b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+void lock_set_init(struct lock_set* set) {
+    set->stripes = NULL;
+    set->versions = NULL;
+    set->size = 0;
+    set->capacity = 0;
+}
+
+bool lock_set_build(struct lock_set* set, const struct shared_lock_t* lock, const struct write_set* write_set) {
+    if (unlikely(write_set->size > set->capacity)) {
+        if (unlikely(!lock_set_grow(set, write_set->size))) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < write_set->size; i++) {
+        set->stripes[i] = find_lock(lock, write_set_entry(write_set, i)->address);
+    }
+
+    if (write_set->size <= LOCK_SET_INSERTION_SORT_THRESHOLD) {
+        for (size_t i = 1; i < write_set->size; i++) {
+            int stripe = set->stripes[i];
+            size_t j = i;
+            for (; j > 0 && set->stripes[j - 1] > stripe; j--) {
+                set->stripes[j] = set->stripes[j - 1];
+            }
+            set->stripes[j] = stripe;
+        }
+    }
+    else {
+        qsort(set->stripes, write_set->size, sizeof(int), lock_set_compare);
+    }
+
+    set->size = 0; // Keep one copy of every stripe that several written words alias to
+    for (size_t i = 0; i < write_set->size; i++) {
+        if (set->size == 0 || set->stripes[set->size - 1] != set->stripes[i]) {
+            set->stripes[set->size++] = set->stripes[i];
+        }
+    }
+    return true;
+}
+
+bool lock_set_grow(struct lock_set* set, size_t capacity) {
+    size_t new_capacity = set->capacity == 0 ? LOCK_SET_INITIAL_CAPACITY : set->capacity;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    int* stripes = (int*) realloc(set->stripes, new_capacity * sizeof(int));
+    if (unlikely(!stripes)) {
+        return false;
+    }
+    set->stripes = stripes;
+
+    uint64_t* versions = (uint64_t*) realloc(set->versions, new_capacity * sizeof(uint64_t));
+    if (unlikely(!versions)) {
+        return false;
+    }
+    set->versions = versions;
+    set->capacity = new_capacity;
+    return true;
+}
+
+bool lock_set_add(struct lock_set* set, int stripe, uint64_t version) {
+    if (unlikely(set->size == set->capacity)) {
+        if (unlikely(!lock_set_grow(set, set->size + 1))) {
+            return false;
+        }
+    }
+
+    set->stripes[set->size] = stripe;
+    set->versions[set->size] = version;
+    set->size++;
+    return true;
+}
+
+/** Tell whether a stripe is held by the owner of the lock set, from the word of its lock.
+ * Every stripe of the set is held while the set is looked up, so an entry naming the stripe proves ownership.
+ * @param set       Lock set
+ * @param word      Word sampled from the lock of the stripe
+ * @param stripe    Index of the stripe
+ * @param version   Receives the version the stripe had before being locked, if owned
+ * @return Whether the stripe is held by the owner of the lock set
+**/
+bool lock_set_owns(const struct lock_set* set, uint64_t word, int stripe, uint64_t* version) {
+    if (!(word & VERSIONED_SPINLOCK_LOCKED)) {
+        return false;
+    }
+
+    uint64_t entry = VERSIONED_SPINLOCK_ENTRY(word);
+    if (entry < set->size && set->stripes[entry] == stripe) {
+        *version = set->versions[entry];
+        return true;
+    }
+    return false;
+}
+
+void lock_set_cleanup(struct lock_set* set) {
+    set->size = 0; // Keep the capacity for the next transaction
+}
+
+void lock_set_destroy(struct lock_set* set) {
+    free(set->stripes);
+    free(set->versions);
+    lock_set_init(set);
+}
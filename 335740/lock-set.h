@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "macros.h"
+#include "shared-lock.h"
+#include "write-set.h"
+
+#define LOCK_SET_INITIAL_CAPACITY 64
+#define LOCK_SET_INSERTION_SORT_THRESHOLD 16 // Number of stripes up to which insertion sort beats qsort
+
+/**
+ * @brief Distinct lock stripes held by a transaction, with the version each had before being locked.
+ * They are in ascending order when built from a write set at commit time, and in locking order when added one by one
+ * at write time (encounter-time locking).
+ */
+struct lock_set {
+    int* stripes;
+    uint64_t* versions;
+    size_t size;
+    size_t capacity;
+};
+
+void lock_set_init(struct lock_set* set);
+
+bool lock_set_build(struct lock_set* set, const struct shared_lock_t* lock, const struct write_set* write_set);
+
+bool lock_set_grow(struct lock_set* set, size_t capacity); // private fn
+
+bool lock_set_add(struct lock_set* set, int stripe, uint64_t version);
+
+bool lock_set_owns(const struct lock_set* set, uint64_t word, int stripe, uint64_t* version);
+
+void lock_set_cleanup(struct lock_set* set);
+
+void lock_set_destroy(struct lock_set* set);
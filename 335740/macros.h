@@ -34,3 +34,19 @@
     #define unused(variable)
     #warning This compiler has no support for GCC attributes
 #endif
+
+/** Size of a cache line (in bytes), used to keep thread-private data apart.
+**/
+#undef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+
+/** Define a function as always inlined, so that every caller gets a copy specialized for its constant arguments.
+**/
+#undef force_inline
+#ifdef __GNUC__
+    #define force_inline \
+        inline __attribute__((always_inline))
+#else
+    #define force_inline \
+        inline
+#endif
@@ -0,0 +1,85 @@
+#define _GNU_SOURCE // MAP_ANONYMOUS, MAP_HUGETLB and syscall
+
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mapping.h"
+
+/** Map zeroed memory with the huge pages and the NUMA placement of a region.
+ * Pages are faulted in at once, unless with first-touch placement, where each lands on the node of the thread writing it first.
+ * @param size      Size to map (in bytes), rounded up to the page size actually used
+ * @param align     Alignment of the mapping (power of 2)
+ * @param config    Tunables of the region
+ * @return Start of the mapping, NULL when running out of memory
+**/
+void* mapping_alloc(size_t* size, size_t align, const struct config* config) {
+    if (config->huge_pages == HUGE_PAGES_EXPLICIT && align <= MAPPING_HUGE_PAGE_SIZE) {
+        size_t huge_size = (*size + MAPPING_HUGE_PAGE_SIZE - 1) & ~(size_t) (MAPPING_HUGE_PAGE_SIZE - 1);
+        void* address = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (address != MAP_FAILED) {
+            *size = huge_size;
+            mapping_advise(address, huge_size, config);
+            mapping_populate(address, huge_size, config);
+            return address;
+        } // Otherwise the huge page pool is too small: use transparent huge pages instead
+    }
+
+    size_t page = config->huge_pages != HUGE_PAGES_OFF ? MAPPING_HUGE_PAGE_SIZE : MAPPING_PAGE_SIZE;
+    size_t alignment = align > page ? align : page;
+    *size = (*size + page - 1) & ~(page - 1);
+
+    // Map one alignment more than needed, then trim the mapping to an aligned start
+    size_t padded = *size + (alignment > MAPPING_PAGE_SIZE ? alignment : 0);
+    unsigned char* address = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (unlikely(address == MAP_FAILED)) {
+        return NULL;
+    }
+    unsigned char* start = (unsigned char*) (((uintptr_t) address + alignment - 1) & ~(uintptr_t) (alignment - 1));
+    if (start > address) {
+        munmap(address, start - address);
+    }
+    if (address + padded > start + *size) {
+        munmap(start + *size, address + padded - (start + *size));
+    }
+
+    mapping_advise(start, *size, config);
+    mapping_populate(start, *size, config);
+    return start;
+}
+
+/** Apply the huge pages and the NUMA placement of a region to a mapping whose pages are not touched yet.
+ * @param address   Start of the mapping (page aligned)
+ * @param size      Size of the mapping (in bytes)
+ * @param config    Tunables of the region
+**/
+void mapping_advise(void* address, size_t size, const struct config* config) {
+    if (config->huge_pages != HUGE_PAGES_OFF) {
+        madvise(address, size, MADV_HUGEPAGE); // Not fatal: the kernel may not support transparent huge pages
+    }
+
+    if (config->numa_placement == NUMA_PLACEMENT_INTERLEAVE) { // Spread the pages over every node the process may use
+        unsigned long nodes[MAPPING_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+        if (syscall(SYS_get_mempolicy, NULL, nodes, MAPPING_MAX_NODES, NULL, MPOL_F_MEMS_ALLOWED) == 0) {
+            syscall(SYS_mbind, address, size, MPOL_INTERLEAVE, nodes, MAPPING_MAX_NODES, 0); // Not fatal either
+        }
+    }
+}
+
+void mapping_free(void* address, size_t size) {
+    munmap(address, size);
+}
+
+/** Fault the pages of a mapping in, so that transactions do not pay for zeroing them (all but first-touch placement).
+ * @param address   Start of the mapping (page aligned)
+ * @param size      Size of the mapping (in bytes)
+ * @param config    Tunables of the region
+**/
+void mapping_populate(void* address, size_t size, const struct config* config) {
+    if (config->numa_placement == NUMA_PLACEMENT_FIRST_TOUCH) {
+        return;
+    }
+    for (size_t offset = 0; offset < size; offset += MAPPING_PAGE_SIZE) {
+        ((volatile unsigned char*) address)[offset] = 0;
+    }
+}
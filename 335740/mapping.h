@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "config.h"
+#include "macros.h"
+
+#define MAPPING_PAGE_SIZE 4096
+#define MAPPING_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MAPPING_MAX_NODES 1024 // Bits of the NUMA node masks passed to the kernel
+
+/** Whether a region maps its memory itself (huge pages or NUMA placement) rather than taking it from the heap.
+ * @param config Tunables of the region
+ * @return Whether memory should come from mapping_alloc
+**/
+static inline bool mapping_enabled(const struct config* config) {
+    return config->huge_pages != HUGE_PAGES_OFF || config->numa_placement != NUMA_PLACEMENT_OFF;
+}
+
+void* mapping_alloc(size_t* size, size_t align, const struct config* config);
+
+void mapping_advise(void* address, size_t size, const struct config* config);
+
+void mapping_populate(void* address, size_t size, const struct config* config); // private fn
+
+void mapping_free(void* address, size_t size);
@@ -0,0 +1,229 @@
+#include "profiler.h"
+
+#ifdef TM_PROFILE // Nothing is recorded otherwise
+
+/** Initialize a profiler with an empty shadow table.
+ * @param profiler  Profiler to initialize
+ * @param period    One conflict in this many is sampled
+ * @param top       Entries of each ranking in the report
+ * @param align     Alignment of the region (in bytes)
+ * @param words     Number of words of the first segment, sizing the shadow table
+ * @return Whether the shadow table could be allocated
+**/
+bool profiler_init(struct profiler* profiler, unsigned period, int top, size_t align, size_t words) {
+    int bits = PROFILER_SHADOW_MIN_BITS;
+    while (bits < PROFILER_SHADOW_MAX_BITS && ((size_t)1 << bits) < 2 * words) {
+        bits++;
+    }
+    profiler->shadow = (struct shadow_entry*) calloc((size_t)1 << bits, sizeof(struct shadow_entry)); // Pages only touched once written
+    if (unlikely(!profiler->shadow)) {
+        return false;
+    }
+    profiler->shadow_bits = bits;
+    profiler->shadow_shift = __builtin_ctzl(align);
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        atomic_init(&profiler->rings[i], NULL);
+    }
+    pthread_mutex_init(&profiler->overflow_lock, NULL);
+    profiler->period = period;
+    profiler->top = top;
+    return true;
+}
+
+/** Count a conflict that aborted a transaction of the calling thread, and sample it once in a period.
+ * @param profiler  Profiler of the region
+ * @param stripe    Stripe that failed to be acquired or validated
+ * @param address   Word accessed under the stripe (NULL if unknown)
+ * @param class     Whether the word itself changed
+**/
+void profiler_record(struct profiler* profiler, int stripe, const void* address, enum conflict_class class) {
+    int thread = thread_id_get();
+    struct conflict_ring* ring = atomic_load_explicit(&profiler->rings[thread], memory_order_relaxed);
+    if (unlikely(ring == NULL)) {
+        ring = (struct conflict_ring*) calloc(1, sizeof(struct conflict_ring));
+        if (unlikely(!ring)) { // Not sampled
+            return;
+        }
+        struct conflict_ring* expected = NULL;
+        if (!atomic_compare_exchange_strong(&profiler->rings[thread], &expected, ring)) { // Only threads beyond THREAD_ID_MAX race for it
+            free(ring);
+            ring = expected;
+        }
+    }
+
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_lock(&profiler->overflow_lock);
+    }
+    ring->classes[class]++;
+    if (ring->conflicts++ % profiler->period == 0) {
+        struct conflict_sample* sample = &ring->samples[ring->sampled++ % PROFILER_RING_SIZE];
+        sample->stripe = stripe;
+        sample->address = address;
+    }
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_unlock(&profiler->overflow_lock);
+    }
+}
+
+/** Stamp a word written by a commit, before its stripe is released.
+ * @param profiler  Profiler of the region
+ * @param address   Address of the word
+ * @param wv        Write version of the commit (or any version above the read version of every transaction that read the old value)
+**/
+void profiler_shadow_store(struct profiler* profiler, const void* address, uint64_t wv) {
+    size_t home = profiler_shadow_home(profiler, address);
+    size_t mask = ((size_t)1 << profiler->shadow_bits) - 1;
+    for (size_t i = 0; i < PROFILER_SHADOW_PROBES; i++) {
+        struct shadow_entry* entry = &profiler->shadow[(home + i) & mask];
+        uintptr_t current = atomic_load_explicit(&entry->address, memory_order_relaxed);
+        if (current == 0 && atomic_compare_exchange_strong_explicit(&entry->address, &current, (uintptr_t) address, memory_order_relaxed, memory_order_relaxed)) {
+            current = (uintptr_t) address;
+        }
+        if (current == (uintptr_t) address) { // Entries are never freed, so the word has no other one
+            atomic_store_explicit(&entry->version, wv, memory_order_relaxed);
+            return;
+        }
+    }
+    atomic_store_explicit(&profiler->shadow[home].overflowed, true, memory_order_relaxed);
+}
+
+/** Tell whether a word was written by a commit after a given version.
+ * @param profiler  Profiler of the region
+ * @param address   Address of the word
+ * @param since     Version the word was read at
+ * @return CONFLICT_TRUE if the word changed since, CONFLICT_FALSE if it did not, CONFLICT_UNKNOWN if it may be untracked
+**/
+enum conflict_class profiler_shadow_check(struct profiler* profiler, const void* address, uint64_t since) {
+    size_t home = profiler_shadow_home(profiler, address);
+    size_t mask = ((size_t)1 << profiler->shadow_bits) - 1;
+    for (size_t i = 0; i < PROFILER_SHADOW_PROBES; i++) {
+        struct shadow_entry* entry = &profiler->shadow[(home + i) & mask];
+        uintptr_t current = atomic_load_explicit(&entry->address, memory_order_relaxed);
+        if (current == (uintptr_t) address) {
+            return atomic_load_explicit(&entry->version, memory_order_relaxed) > since ? CONFLICT_TRUE : CONFLICT_FALSE;
+        }
+        if (current == 0) { // Never written since the region was created
+            break;
+        }
+    }
+    return atomic_load_explicit(&profiler->shadow[home].overflowed, memory_order_relaxed) ? CONFLICT_UNKNOWN : CONFLICT_FALSE;
+}
+
+/** Print the stripes and the words that aborted the most transactions, among the samples every thread kept.
+ * @param profiler  Profiler of the region, with no running transaction
+ * @param stream    Stream receiving the report
+**/
+void profiler_report(struct profiler* profiler, FILE* stream) {
+    uint64_t conflicts = 0;
+    uint64_t classes[NUM_CONFLICT_CLASSES] = { 0 };
+    size_t num_samples = 0;
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        struct conflict_ring* ring = atomic_load(&profiler->rings[i]);
+        if (ring != NULL) {
+            conflicts += ring->conflicts;
+            for (int j = 0; j < NUM_CONFLICT_CLASSES; j++) {
+                classes[j] += ring->classes[j];
+            }
+            num_samples += ring->sampled < PROFILER_RING_SIZE ? ring->sampled : PROFILER_RING_SIZE;
+        }
+    }
+    fprintf(stream, "tm profile: %lu conflicts, %lu samples kept (1 in %u sampled)\n", (unsigned long) conflicts, (unsigned long) num_samples, profiler->period);
+    uint64_t changed = classes[CONFLICT_TRUE] + classes[CONFLICT_FALSE];
+    fprintf(stream, "tm profile: %lu true conflicts, %lu false conflicts (%.1f%% of the changed stripes had the words read unchanged), %lu unknown (words the shadow table could not track), %lu on held stripes\n",
+            (unsigned long) classes[CONFLICT_TRUE], (unsigned long) classes[CONFLICT_FALSE],
+            changed > 0 ? 100.0 * (double) classes[CONFLICT_FALSE] / (double) changed : 0.0,
+            (unsigned long) classes[CONFLICT_UNKNOWN], (unsigned long) classes[CONFLICT_HELD]);
+    if (num_samples == 0) {
+        return;
+    }
+
+    struct conflict_sample* samples = (struct conflict_sample*) malloc(num_samples * sizeof(struct conflict_sample));
+    if (unlikely(!samples)) {
+        return;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        struct conflict_ring* ring = atomic_load(&profiler->rings[i]);
+        if (ring != NULL) {
+            size_t kept = ring->sampled < PROFILER_RING_SIZE ? ring->sampled : PROFILER_RING_SIZE;
+            memcpy(samples + offset, ring->samples, kept * sizeof(struct conflict_sample));
+            offset += kept;
+        }
+    }
+
+    profiler_rank(samples, num_samples, false, profiler->top, stream);
+    profiler_rank(samples, num_samples, true, profiler->top, stream);
+    free(samples);
+}
+
+void profiler_cleanup(struct profiler* profiler) {
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        free(atomic_load(&profiler->rings[i]));
+    }
+    pthread_mutex_destroy(&profiler->overflow_lock);
+    free(profiler->shadow);
+}
+
+/** Print the stripes (or the words) appearing in the most samples.
+ * @param samples       Samples, sorted in place
+ * @param num_samples   Number of samples
+ * @param by_address    Whether to rank the words rather than the stripes (samples without an address being left out)
+ * @param top           Entries of the ranking
+ * @param stream        Stream receiving the ranking
+**/
+void profiler_rank(struct conflict_sample* samples, size_t num_samples, bool by_address, int top, FILE* stream) {
+    qsort(samples, num_samples, sizeof(struct conflict_sample), by_address ? profiler_compare_address : profiler_compare_stripe);
+
+    struct conflict_count* counts = (struct conflict_count*) malloc(num_samples * sizeof(struct conflict_count));
+    if (unlikely(!counts)) {
+        return;
+    }
+    size_t num_counts = 0;
+    for (size_t i = 0; i < num_samples; i++) {
+        if (by_address && samples[i].address == NULL) {
+            continue;
+        }
+        bool same = num_counts > 0 && (by_address ? counts[num_counts - 1].sample.address == samples[i].address
+                : counts[num_counts - 1].sample.stripe == samples[i].stripe);
+        if (!same) {
+            counts[num_counts].sample = samples[i];
+            counts[num_counts].count = 0;
+            num_counts++;
+        }
+        counts[num_counts - 1].count++;
+    }
+    qsort(counts, num_counts, sizeof(struct conflict_count), profiler_compare_count);
+
+    fprintf(stream, "tm profile: %lu distinct %s, hottest:\n", (unsigned long) num_counts, by_address ? "words" : "stripes");
+    for (size_t i = 0; i < num_counts && i < (size_t) top; i++) {
+        if (by_address) {
+            fprintf(stream, "tm profile:   word %p (stripe %d) %lu samples (%.1f%%)\n", counts[i].sample.address, counts[i].sample.stripe,
+                    (unsigned long) counts[i].count, 100.0 * (double) counts[i].count / (double) num_samples);
+        }
+        else {
+            fprintf(stream, "tm profile:   stripe %d %lu samples (%.1f%%)\n", counts[i].sample.stripe,
+                    (unsigned long) counts[i].count, 100.0 * (double) counts[i].count / (double) num_samples);
+        }
+    }
+    free(counts);
+}
+
+int profiler_compare_stripe(const void* a, const void* b) {
+    int x = ((const struct conflict_sample*) a)->stripe;
+    int y = ((const struct conflict_sample*) b)->stripe;
+    return (x > y) - (x < y);
+}
+
+int profiler_compare_address(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t) ((const struct conflict_sample*) a)->address;
+    uintptr_t y = (uintptr_t) ((const struct conflict_sample*) b)->address;
+    return (x > y) - (x < y);
+}
+
+int profiler_compare_count(const void* a, const void* b) { // Most samples first
+    size_t x = ((const struct conflict_count*) a)->count;
+    size_t y = ((const struct conflict_count*) b)->count;
+    return (x < y) - (x > y);
+}
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "thread-id.h"
+
+/** Compile a statement only if the library profiles conflicts (built with -DTM_PROFILE).
+ * @param statement Statement recording or reporting conflicts
+**/
+#undef PROFILE
+#ifdef TM_PROFILE
+    #define PROFILE(statement) statement
+#else
+    #define PROFILE(statement)
+#endif
+
+#define PROFILER_RING_SIZE 4096 // Samples a thread keeps, the oldest ones being overwritten first
+#define PROFILER_SHADOW_MIN_BITS 16 // Log2 of the smallest shadow table
+#define PROFILER_SHADOW_MAX_BITS 24 // Log2 of the largest shadow table (sized from the first segment, two entries per word)
+#define PROFILER_SHADOW_PROBES 16   // Entries a word may be placed in, from its home entry on; words not fitting are untracked
+
+/**
+ * @brief Whether the conflict came from the very word the transaction accessed, or only from its stripe.
+ */
+enum conflict_class {
+    CONFLICT_TRUE,  // A word the transaction read under the stripe was overwritten since
+    CONFLICT_FALSE, // Only other words of the stripe were overwritten (lock table aliasing)
+    CONFLICT_HELD,  // The stripe is held by another transaction, which has not written its words yet
+    CONFLICT_UNKNOWN, // The words read under the stripe did not change, unless one that the shadow table could not track did
+    NUM_CONFLICT_CLASSES
+};
+
+/**
+ * @brief Conflict that aborted a transaction: the stripe that failed to be acquired or validated, and the word accessed under it.
+ */
+struct conflict_sample {
+    const void* address; // NULL if unknown
+    int stripe;
+};
+
+/**
+ * @brief Shadow version of one word, keyed by its exact address.
+ */
+struct shadow_entry {
+    _Atomic uintptr_t address; // Word of the entry (0 while the entry is free)
+    _Atomic uint64_t version;  // Version of the last commit that wrote the word
+    _Atomic bool overflowed;   // Whether a word having this entry as its home found no free entry, and is untracked
+};
+
+/**
+ * @brief Latest conflicts sampled by one thread.
+ */
+struct conflict_ring {
+    struct conflict_sample samples[PROFILER_RING_SIZE];
+    uint64_t conflicts; // Conflicts met so far, sampled or not
+    uint64_t sampled;   // Conflicts sampled so far, the last PROFILER_RING_SIZE ones being kept
+    uint64_t classes[NUM_CONFLICT_CLASSES]; // Conflicts met so far, by class
+};
+
+/**
+ * @brief Sampling profiler of the conflicts aborting the transactions of a region, reporting the hottest stripes
+ * and words when the region is destroyed.
+ */
+struct profiler {
+    struct conflict_ring* _Atomic rings[THREAD_ID_MAX + 1]; // Indexed by thread id, allocated at the first conflict of the thread
+    pthread_mutex_t overflow_lock; // Serializes the threads sharing the ring of THREAD_ID_OVERFLOW
+    struct shadow_entry* shadow;   // Version of the last commit that wrote each word, open-addressed by word address
+    int shadow_bits;               // Log2 of the number of shadow entries
+    int shadow_shift;              // Log2 of the alignment of the region
+    unsigned period;               // One conflict in this many is sampled
+    int top;                       // Entries of each ranking in the report
+};
+
+/**
+ * @brief Number of samples that share a key (stripe or address), in a ranking of the report.
+ */
+struct conflict_count {
+    struct conflict_sample sample;
+    size_t count;
+};
+
+bool profiler_init(struct profiler* profiler, unsigned period, int top, size_t align, size_t words);
+
+void profiler_record(struct profiler* profiler, int stripe, const void* address, enum conflict_class class);
+
+void profiler_shadow_store(struct profiler* profiler, const void* address, uint64_t wv);
+
+enum conflict_class profiler_shadow_check(struct profiler* profiler, const void* address, uint64_t since);
+
+/** Get the entry a word is first looked for in, in the shadow table.
+ * @param profiler  Profiler of the region
+ * @param address   Address of the word
+ * @return Index of the home entry of the word
+**/
+static inline size_t profiler_shadow_home(const struct profiler* profiler, const void* address) {
+    return (size_t) ((((uint64_t) (uintptr_t) address >> profiler->shadow_shift) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - profiler->shadow_bits));
+}
+
+void profiler_report(struct profiler* profiler, FILE* stream);
+
+void profiler_cleanup(struct profiler* profiler);
+
+void profiler_rank(struct conflict_sample* samples, size_t num_samples, bool by_address, int top, FILE* stream); // private fn
+
+int profiler_compare_stripe(const void* a, const void* b); // private fn
+
+int profiler_compare_address(const void* a, const void* b); // private fn
+
+int profiler_compare_count(const void* a, const void* b); // private fn
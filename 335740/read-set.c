@@ -1,55 +1,95 @@
 #include "read-set.h"
 
-void read_set_init(struct read_node** first_node, struct read_node** last_node) {
-    *first_node = NULL;
-    *last_node = NULL;
+void read_set_init(struct read_set* set) {
+    set->stripes = NULL;
+#ifdef TM_PROFILE
+    set->addresses = NULL;
+#endif
+    set->size = 0;
+    set->capacity = 0;
+    set->ranges = NULL;
+    set->num_ranges = 0;
+    set->range_capacity = 0;
 }
 
-bool read_set_add(struct read_node** first_node, struct read_node** last_node, const void* source_word) {
-    if (*first_node == NULL) {
-        return read_set_add_first(first_node, last_node, source_word);
+/** Add the stripe of a read word to the read set.
+ * @param set       Read set
+ * @param stripe    Stripe of the word
+ * @param address   Address of the word, only kept by profiled builds
+ * @return Whether the stripe was added
+**/
+bool read_set_add(struct read_set* set, int stripe, const void* unused(address)) {
+    if (unlikely(set->size == set->capacity)) {
+        if (unlikely(!read_set_grow(set))) {
+            return false;
+        }
     }
-    return read_set_add_next(last_node, source_word);
-}
 
-bool read_set_add_first(struct read_node** first_node, struct read_node** last_node, const void* source_word) {
-    struct read_node* new_node;
-    if (unlikely(!read_node_create(&new_node, source_word))) {
-        return false;
-    }
-
-    *first_node = new_node;
-    *last_node = new_node;
+#ifdef TM_PROFILE
+    set->addresses[set->size] = address;
+#endif
+    set->stripes[set->size++] = stripe;
     return true;
 }
 
-bool read_set_add_next(struct read_node** last_node, const void* source_word) {
-    struct read_node* new_node;
-    if (unlikely(!read_node_create(&new_node, source_word))) {
+bool read_set_grow(struct read_set* set) {
+    size_t capacity = set->capacity == 0 ? READ_SET_INITIAL_CAPACITY : 2 * set->capacity;
+    int* stripes = (int*) realloc(set->stripes, capacity * sizeof(int));
+    if (unlikely(!stripes)) {
         return false;
     }
 
-    (*last_node)->next = new_node;
-    *last_node = new_node;
+    set->stripes = stripes;
+#ifdef TM_PROFILE
+    const void** addresses = (const void**) realloc(set->addresses, capacity * sizeof(const void*));
+    if (unlikely(!addresses)) {
+        return false;
+    }
+    set->addresses = addresses;
+#endif
+    set->capacity = capacity;
     return true;
 }
 
-bool read_node_create(struct read_node** new_node, const void* source_word) {
-    *new_node = (struct read_node*) malloc(sizeof(struct read_node));
-    if (unlikely(!new_node)) {
-        return false;
+/** Add the stripe run of a range read at once to the read set.
+ * @param set       Read set
+ * @param first     First stripe of the run
+ * @param count     Number of stripes of the run
+ * @param source    Start address of the range, only kept by profiled builds
+ * @param size      Size of the range (in bytes), only kept by profiled builds
+ * @return Whether the run was added
+**/
+bool read_set_add_range(struct read_set* set, int first, int count, const void* unused(source), size_t unused(size)) {
+    if (unlikely(set->num_ranges == set->range_capacity)) {
+        size_t capacity = set->range_capacity == 0 ? READ_SET_INITIAL_CAPACITY : 2 * set->range_capacity;
+        struct read_range* ranges = (struct read_range*) realloc(set->ranges, capacity * sizeof(struct read_range));
+        if (unlikely(!ranges)) {
+            return false;
+        }
+        set->ranges = ranges;
+        set->range_capacity = capacity;
     }
 
-    (*new_node)->address = source_word;
-    (*new_node)->next = NULL;
+    set->ranges[set->num_ranges].first = first;
+    set->ranges[set->num_ranges].count = count;
+#ifdef TM_PROFILE
+    set->ranges[set->num_ranges].source = source;
+    set->ranges[set->num_ranges].size = size;
+#endif
+    set->num_ranges++;
     return true;
 }
 
-void read_set_cleanup(struct read_node* first_node) {
-    struct read_node* next_node;
-    while (first_node != NULL) {
-        next_node = first_node->next;
-        free(first_node);
-        first_node = next_node;
-    }
+void read_set_cleanup(struct read_set* set) {
+    set->size = 0; // Keep the capacity for the next transaction
+    set->num_ranges = 0;
+}
+
+void read_set_destroy(struct read_set* set) {
+    free(set->stripes);
+#ifdef TM_PROFILE
+    free(set->addresses);
+#endif
+    free(set->ranges);
+    read_set_init(set);
 }
@@ -1,28 +1,51 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "macros.h"
 
+#define READ_SET_INITIAL_CAPACITY 64
+
+/**
+ * @brief Run of consecutive lock stripes (wrapping around the lock table) covering a range read at once.
+ */
+struct read_range {
+    int first;
+    int count;
+#ifdef TM_PROFILE
+    const void* source; // Start address of the range
+    size_t size;        // Size of the range (in bytes)
+#endif
+};
+
 /**
- * @brief Holds address of a read word and a pointer to the next read node.
+ * @brief Growable arrays holding the lock-stripe indices of the read words, and the stripe runs of the ranges read
+ * at once (kept across transactions of a thread).
  */
-struct read_node {
-    const void* address;
-    struct read_node* next;
+struct read_set {
+    int* stripes;
+#ifdef TM_PROFILE
+    const void** addresses; // Word read under every stripe, to tell which one a conflict hit
+#endif
+    size_t size;
+    size_t capacity;
+    struct read_range* ranges;
+    size_t num_ranges;
+    size_t range_capacity;
 };
 
-void read_set_init(struct read_node** first_node, struct read_node** last_node);
+void read_set_init(struct read_set* set);
 
-bool read_set_add(struct read_node** first_node, struct read_node** last_node, const void* source_word);
+bool read_set_add(struct read_set* set, int stripe, const void* address);
 
-bool read_set_add_first(struct read_node** first_node, struct read_node** last_node, const void* source_word); // private fn
+bool read_set_grow(struct read_set* set); // private fn
 
-bool read_set_add_next(struct read_node** last_node, const void* source_word); // private fn
+bool read_set_add_range(struct read_set* set, int first, int count, const void* source, size_t size);
 
-bool read_node_create(struct read_node** new_node, const void* source_word); // private fn
+void read_set_cleanup(struct read_set* set);
 
-void read_set_cleanup(struct read_node* first_node);
+void read_set_destroy(struct read_set* set);
 
 
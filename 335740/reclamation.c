@@ -0,0 +1,92 @@
+#include "reclamation.h"
+
+void reclamation_init(struct reclamation* reclamation) {
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        atomic_init(&reclamation->lists[i], NULL);
+    }
+    pthread_mutex_init(&reclamation->overflow_lock, NULL);
+}
+
+/** Retire a segment to the limbo list of the calling thread, then recycle the segments no running transaction can read anymore.
+ * @param reclamation   Limbo lists of the region
+ * @param slab          Allocator of the segments, receiving the recycled ones
+ * @param registry      Registry announcing the clock value every running transaction began at
+ * @param clock         Global clock
+ * @param node          Header of the segment, already unlinked from the region
+ * @param retired_at    Clock value taken after the commit that freed the segment
+**/
+void reclamation_retire(struct reclamation* reclamation, struct slab* slab, struct snapshot_registry* registry, struct global_clock* clock, struct segment_node* node, uint64_t retired_at) {
+    int thread = thread_id_get();
+    struct limbo_list* list = reclamation_list_get(reclamation, thread);
+    if (unlikely(!list)) { // The segment stays unused until its chunk is freed with the slab
+        return;
+    }
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_lock(&reclamation->overflow_lock);
+    }
+
+    node->retired_at = retired_at;
+    node->next = NULL;
+    if (list->tail != NULL) {
+        list->tail->next = node;
+    }
+    else {
+        list->head = node;
+    }
+    list->tail = node;
+
+    if (++list->pending >= RECLAMATION_BATCH) {
+        list->pending = 0;
+        // A transaction that began before the clock reached retired_at may have read a pointer to the segment,
+        // later ones see the commit that freed it and never reach it.
+        reclamation_collect(list, slab, snapshot_registry_oldest_begin(registry, clock));
+    }
+
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_unlock(&reclamation->overflow_lock);
+    }
+}
+
+/** Get the limbo list of a thread, allocating it at the first segment the thread retires.
+ * @param reclamation   Limbo lists of the region
+ * @param thread        Id of the calling thread
+ * @return Limbo list of the thread, NULL when running out of memory
+**/
+struct limbo_list* reclamation_list_get(struct reclamation* reclamation, int thread) {
+    struct limbo_list* list = atomic_load_explicit(&reclamation->lists[thread], memory_order_acquire);
+    if (likely(list != NULL)) {
+        return list;
+    }
+
+    list = (struct limbo_list*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct limbo_list));
+    if (unlikely(!list)) {
+        return NULL;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->pending = 0;
+    struct limbo_list* expected = NULL;
+    if (!atomic_compare_exchange_strong(&reclamation->lists[thread], &expected, list)) { // Only threads beyond THREAD_ID_MAX race for it
+        free(list);
+        list = expected;
+    }
+    return list;
+}
+
+void reclamation_collect(struct limbo_list* list, struct slab* slab, uint64_t oldest) {
+    while (list->head != NULL && list->head->retired_at <= oldest) { // Retired in clock order, so stop at the first one still in use
+        struct segment_node* next = list->head->next;
+        slab_recycle(slab, list->head);
+        list->head = next;
+    }
+    if (list->head == NULL) {
+        list->tail = NULL;
+    }
+}
+
+void reclamation_cleanup(struct reclamation* reclamation) {
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        free(atomic_load(&reclamation->lists[i])); // Retired segments are freed with the chunks of the slab
+    }
+    pthread_mutex_destroy(&reclamation->overflow_lock);
+}
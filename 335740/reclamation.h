@@ -0,0 +1,43 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "global-clock.h"
+#include "macros.h"
+#include "slab.h"
+#include "snapshot-registry.h"
+#include "thread-id.h"
+
+#define RECLAMATION_BATCH 64 // Segments a thread retires between two attempts to return its limbo list
+
+/**
+ * @brief Segments retired by one thread, oldest first, alone on its cache line.
+ */
+struct limbo_list {
+    struct segment_node* head;
+    struct segment_node* tail;
+    size_t pending; // Segments retired since the last attempt to return the list
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Limbo lists of the segments freed by committed transactions, which running transactions may still read.
+ */
+struct reclamation {
+    struct limbo_list* _Atomic lists[THREAD_ID_MAX + 1]; // Indexed by thread id, allocated at the first segment the thread retires
+    pthread_mutex_t overflow_lock;              // Serializes the threads sharing the list of THREAD_ID_OVERFLOW
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+void reclamation_init(struct reclamation* reclamation);
+
+void reclamation_retire(struct reclamation* reclamation, struct slab* slab, struct snapshot_registry* registry, struct global_clock* clock, struct segment_node* node, uint64_t retired_at);
+
+struct limbo_list* reclamation_list_get(struct reclamation* reclamation, int thread); // private fn
+
+void reclamation_collect(struct limbo_list* list, struct slab* slab, uint64_t oldest); // private fn
+
+void reclamation_cleanup(struct reclamation* reclamation);
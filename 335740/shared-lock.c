@@ -1,49 +1,201 @@
+#include <immintrin.h>
+
 #include "shared-lock.h"
 
-void shared_lock_init(struct shared_lock_t* lock) {
-    atomic_store(&lock->clock, 0);
-    for (int i = 0; i < NUM_LOCKS; i++) {
+/** Initialize the global lock, with a lock table, or with the locks living at the start of the chunks of an arena.
+ * @param lock      Global lock object
+ * @param config    Tunables of the region
+ * @param size      Size of the first segment (in bytes), sizing the lock table
+ * @param align     Size of a word (in bytes)
+ * @param arena     Arena holding the segments and their locks, NULL for a lock table
+ * @return Whether the global lock could be initialized
+**/
+bool shared_lock_init(struct shared_lock_t* lock, const struct config* config, size_t size, size_t align, const struct arena* arena) {
+    if (unlikely(!global_clock_init(&lock->clock, config->clock_scheme))) {
+        return false;
+    }
+    lock->wide_validation = __builtin_cpu_supports("avx2");
+
+    if (arena != NULL) { // Stripe i covers the i-th grain of the arena, and the stripes of chunk headers are never used
+        lock->locks = (struct versioned_spinlock_t*) arena->base;
+        lock->base = arena->base;
+        lock->shift = arena->grain_shift;
+        lock->mask = ((uintptr_t)1 << ARENA_STRIPE_BITS) - 1;
+        lock->stride_shift = 0;
+        lock->chunk_shift = arena->chunk_shift;
+        lock->chunk_stripe_bits = arena->chunk_shift - arena->grain_shift;
+        lock->chunk_stripe_mask = ((uintptr_t)1 << lock->chunk_stripe_bits) - 1;
+        lock->header_stripes = arena->header >> arena->grain_shift;
+        lock->owns_table = false;
+        lock->table_mapping = 0; // The arena maps (and unmaps) the locks itself
+        return true;
+    }
+
+    int bits = config->lock_table_bits;
+    if (bits == 0) { // Two stripes per word of the first segment, within bounds
+        bits = LOCK_TABLE_MIN_BITS;
+        while (bits < LOCK_TABLE_MAX_BITS && ((size_t)1 << bits) < 2 * (size / align)) {
+            bits++;
+        }
+    }
+
+    lock->base = 0;
+    lock->shift = __builtin_ctzl(align);
+    lock->mask = ((uintptr_t)1 << bits) - 1;
+    lock->stride_shift = config->lock_table_padded ? __builtin_ctzl(CACHE_LINE_SIZE / sizeof(struct versioned_spinlock_t)) : 0;
+    lock->chunk_shift = 0;
+    lock->chunk_stripe_bits = ARENA_STRIPE_BITS; // Stripes are below 2^31, so they all fall in "chunk" 0
+    lock->chunk_stripe_mask = lock->mask;
+    lock->header_stripes = 0;
+    lock->owns_table = true;
+
+    size_t entries = ((size_t)1 << bits) << lock->stride_shift;
+    lock->table_mapping = 0;
+    if (mapping_enabled(config)) { // Mapped pages are zero, that is unlocked at version 0, and left for the first writer to touch
+        lock->table_mapping = entries * sizeof(struct versioned_spinlock_t);
+        lock->locks = (struct versioned_spinlock_t*) mapping_alloc(&lock->table_mapping, CACHE_LINE_SIZE, config);
+        if (unlikely(!lock->locks)) {
+            global_clock_cleanup(&lock->clock);
+            return false;
+        }
+        return true;
+    }
+
+    lock->locks = (struct versioned_spinlock_t*) aligned_alloc(CACHE_LINE_SIZE, entries * sizeof(struct versioned_spinlock_t));
+    if (unlikely(!lock->locks)) {
+        global_clock_cleanup(&lock->clock);
+        return false;
+    }
+    for (size_t i = 0; i < entries; i++) {
         versioned_spinlock_init(&lock->locks[i]);
     }
-    pthread_mutex_init(&lock->segment_lock, NULL);
+    return true;
 }
 
-int shared_lock_global_clock_get(struct shared_lock_t* lock) {
-    return atomic_load(&lock->clock);
+uint64_t shared_lock_global_clock_get(struct shared_lock_t* lock) {
+    return global_clock_sample(&lock->clock);
 }
 
-int shared_lock_global_clock_increment_and_get(struct shared_lock_t* lock) {
-    return __atomic_add_fetch(&lock->clock, 1, __ATOMIC_RELAXED);
+uint64_t shared_lock_global_clock_commit(struct shared_lock_t* lock, uint64_t floor) {
+    return global_clock_commit(&lock->clock, floor);
 }
 
-int find_lock(const void* shared) {
-    return (uintptr_t)shared % NUM_LOCKS;
+void shared_lock_global_clock_advance(struct shared_lock_t* lock, uint64_t version) {
+    global_clock_advance(&lock->clock, version);
 }
 
-bool shared_lock_versioned_spinlock_acquire(struct shared_lock_t* lock, const void* shared) {
-    return versioned_spinlock_acquire(&lock->locks[find_lock(shared)]);
-}
+/** Validate stripes read by a transaction, in order, four at once when the processor has AVX2.
+ * @param lock      Global lock object
+ * @param stripes   Indices of the stripes
+ * @param count     Number of stripes
+ * @param version   Read version, the newest version accepted
+ * @return Number of stripes validated before the first one locked or newer, 'count' if all of them validate
+**/
+size_t shared_lock_versioned_spinlock_validate_stripes(struct shared_lock_t* lock, const int* stripes, size_t count, uint64_t version) {
+    if (lock->wide_validation) {
+        return shared_lock_versioned_spinlock_validate_stripes_avx2(lock, stripes, count, version);
+    }
 
-void shared_lock_versioned_spinlock_release(struct shared_lock_t* lock, const void* shared) {
-    versioned_spinlock_release(&lock->locks[find_lock(shared)]);
-}
+    // A single unsigned comparison per stripe covers both a held lock and a newer version. SSE2 has no 64-bit
+    // comparison, so four stripes are checked per step without branching and the results are folded together.
+    atomic_thread_fence(memory_order_acquire);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (size_t j = i + VALIDATE_PREFETCH_DISTANCE; j < i + VALIDATE_PREFETCH_DISTANCE + 4 && j < count; j++) {
+            __builtin_prefetch(shared_lock_stripe(lock, stripes[j]), 0 /* read */, 0 /* no temporal locality */);
+        }
 
-void shared_lock_versioned_spinlock_update(struct shared_lock_t* lock, const void* shared, int version) {
-    versioned_spinlock_update(&lock->locks[find_lock(shared)], version);
+        uint64_t w0 = atomic_load_explicit(&shared_lock_stripe(lock, stripes[i])->word, memory_order_relaxed);
+        uint64_t w1 = atomic_load_explicit(&shared_lock_stripe(lock, stripes[i + 1])->word, memory_order_relaxed);
+        uint64_t w2 = atomic_load_explicit(&shared_lock_stripe(lock, stripes[i + 2])->word, memory_order_relaxed);
+        uint64_t w3 = atomic_load_explicit(&shared_lock_stripe(lock, stripes[i + 3])->word, memory_order_relaxed);
+        if (unlikely((w0 > version) | (w1 > version) | (w2 > version) | (w3 > version))) {
+            break; // Let the scalar loop find which one failed
+        }
+    }
+    for (; i < count; i++) {
+        if (atomic_load_explicit(&shared_lock_stripe(lock, stripes[i])->word, memory_order_relaxed) > version) {
+            return i;
+        }
+    }
+    return count;
 }
 
-bool shared_lock_versioned_spinlock_validate(struct shared_lock_t* lock, const void* shared, int version) {
-    return versioned_spinlock_validate(&lock->locks[find_lock(shared)], version);
+__attribute__((target("avx2")))
+size_t shared_lock_versioned_spinlock_validate_stripes_avx2(struct shared_lock_t* lock, const int* stripes, size_t count, uint64_t version) {
+    // The four lock addresses are computed as in 'shared_lock_stripe' and gathered in one instruction. AVX2 only
+    // compares signed 64-bit integers, so the top bits of the words and of the version are flipped to order them as unsigned.
+    const __m256i sign = _mm256_set1_epi64x((long long) VERSIONED_SPINLOCK_LOCKED);
+    const __m256i newest = _mm256_xor_si256(_mm256_set1_epi64x((long long) version), sign);
+    const __m256i entry_mask = _mm256_set1_epi64x((long long) lock->chunk_stripe_mask);
+    const __m256i header_stripes = _mm256_set1_epi64x((long long) lock->header_stripes);
+    const __m128i chunk_stripe_bits = _mm_cvtsi32_si128(lock->chunk_stripe_bits);
+    const __m128i chunk_shift = _mm_cvtsi32_si128(lock->chunk_shift);
+    const __m128i entry_shift = _mm_cvtsi32_si128(lock->stride_shift + 3); // Entries of 8 bytes
+    atomic_thread_fence(memory_order_acquire);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (size_t j = i + VALIDATE_PREFETCH_DISTANCE; j < i + VALIDATE_PREFETCH_DISTANCE + 4 && j < count; j++) {
+            __builtin_prefetch(shared_lock_stripe(lock, stripes[j]), 0 /* read */, 0 /* no temporal locality */);
+        }
+
+        __m256i stripe = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*) (stripes + i)));
+        __m256i chunk = _mm256_sll_epi64(_mm256_srl_epi64(stripe, chunk_stripe_bits), chunk_shift);
+        __m256i entry = _mm256_sll_epi64(_mm256_sub_epi64(_mm256_and_si256(stripe, entry_mask), header_stripes), entry_shift);
+        __m256i words = _mm256_i64gather_epi64((const long long*) lock->locks, _mm256_add_epi64(chunk, entry), 1);
+        if (unlikely(!_mm256_testz_si256(_mm256_cmpgt_epi64(_mm256_xor_si256(words, sign), newest), _mm256_set1_epi64x(-1)))) {
+            break; // Let the scalar loop find which one failed
+        }
+    }
+    for (; i < count; i++) {
+        if (atomic_load_explicit(&shared_lock_stripe(lock, stripes[i])->word, memory_order_relaxed) > version) {
+            return i;
+        }
+    }
+    return count;
 }
 
-void shared_lock_segment_lock_acquire(struct shared_lock_t* lock) {
-    pthread_mutex_lock(&lock->segment_lock);
+/** Sample a run of consecutive stripes (wrapping around the table) before reading the words they cover at once.
+ * @param lock      Global lock object
+ * @param first     Index of the first stripe
+ * @param count     Number of stripes, at most the number of stripes in the table
+ * @param newest    Receives the newest version of the run
+ * @return Whether no stripe of the run is locked
+**/
+bool shared_lock_versioned_spinlock_sample_range(struct shared_lock_t* lock, int first, size_t count, uint64_t* newest) {
+    uint64_t folded = 0; // Both the lock bit and the largest version survive an unsigned maximum
+    for (size_t i = 0; i < count; i++) {
+        uint64_t word = versioned_spinlock_sample(shared_lock_stripe(lock, (int) ((first + i) & lock->mask)));
+        folded = word > folded ? word : folded;
+    }
+    *newest = folded;
+    return !(folded & VERSIONED_SPINLOCK_LOCKED);
 }
 
-void shared_lock_segment_lock_release(struct shared_lock_t* lock) {
-    pthread_mutex_unlock(&lock->segment_lock);
+/** Validate a run of consecutive stripes (wrapping around the table) after reading the words they cover at once.
+ * @param lock      Global lock object
+ * @param first     Index of the first stripe
+ * @param count     Number of stripes, at most the number of stripes in the table
+ * @param version   Version every stripe must be at most (unlocked)
+ * @return Position in the run of the first stripe failing validation, 'count' if none
+**/
+size_t shared_lock_versioned_spinlock_validate_range(struct shared_lock_t* lock, int first, size_t count, uint64_t version) {
+    atomic_thread_fence(memory_order_acquire); // Order the data reads being validated before the lock reads
+    for (size_t i = 0; i < count; i++) {
+        const struct versioned_spinlock_t* stripe = shared_lock_stripe(lock, (int) ((first + i) & lock->mask));
+        if (atomic_load_explicit(&stripe->word, memory_order_relaxed) > version) {
+            return i;
+        }
+    }
+    return count;
 }
 
 void shared_lock_cleanup(struct shared_lock_t* lock) {
-    pthread_mutex_destroy(&lock->segment_lock);
+    if (lock->table_mapping > 0) {
+        mapping_free(lock->locks, lock->table_mapping);
+    }
+    else if (lock->owns_table) {
+        free(lock->locks);
+    }
+    global_clock_cleanup(&lock->clock);
 }
\ No newline at end of file
@@ -1,41 +1,90 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <pthread.h>
 #include <stdatomic.h>
 
+#include "arena.h"
+#include "config.h"
+#include "global-clock.h"
+#include "macros.h"
+#include "mapping.h"
 #include "versioned-spinlock.h"
 
-#define NUM_LOCKS 4999
+#define LOCK_TABLE_MIN_BITS 14 // Smallest lock table chosen from the size of the first segment
+#define LOCK_TABLE_MAX_BITS 24 // Largest lock table chosen from the size of the first segment
+#define VALIDATE_PREFETCH_DISTANCE 8 // How many read set entries ahead of the validated one to prefetch
 
 /**
  * @brief Global lock object that controls access to shared memory.
  */
 struct shared_lock_t {
-    _Atomic int clock;
-    struct versioned_spinlock_t locks[NUM_LOCKS];
-    pthread_mutex_t segment_lock;
+    struct global_clock clock;          // Global version clock
+    struct versioned_spinlock_t* locks; // Lock table (one entry per stripe, or one cache line per stripe if padded), or first arena chunk
+    uintptr_t base;                     // Address of stripe 0 (0 for the table, whose stripes wrap around the address space)
+    uintptr_t mask;                     // Number of stripes minus 1 (power of 2)
+    int shift;                          // Log2 of the bytes per stripe, so that consecutive words map to consecutive stripes
+    int stride_shift;                   // Log2 of the number of table entries per stripe
+    int chunk_stripe_bits;              // Log2 of the stripes per arena chunk (past any stripe for the table)
+    uintptr_t chunk_stripe_mask;        // Stripes per arena chunk minus 1 (the table mask for the table)
+    uintptr_t header_stripes;           // Stripes of the lock part of an arena chunk, which hold no word (0 for the table)
+    int chunk_shift;                    // Log2 of the arena chunk size
+    bool owns_table;                    // Whether the locks were allocated here (rather than living in the arena)
+    size_t table_mapping;               // Size of the mapping holding the table (0 if it is on the heap)
+    bool wide_validation;               // Whether the processor gathers and compares four stripes at once (AVX2)
 };
 
-void shared_lock_init(struct shared_lock_t* lock);
+bool shared_lock_init(struct shared_lock_t* lock, const struct config* config, size_t size, size_t align, const struct arena* arena);
 
-int shared_lock_global_clock_get(struct shared_lock_t* lock);
+uint64_t shared_lock_global_clock_get(struct shared_lock_t* lock);
 
-int shared_lock_global_clock_increment_and_get(struct shared_lock_t* lock);
+uint64_t shared_lock_global_clock_commit(struct shared_lock_t* lock, uint64_t floor);
 
-int find_lock(const void* shared);
+void shared_lock_global_clock_advance(struct shared_lock_t* lock, uint64_t version);
 
-bool shared_lock_versioned_spinlock_acquire(struct shared_lock_t* lock, const void* shared);
+/** Map a word address to its lock stripe (one subtraction, one shift and one mask).
+ * @param lock   Global lock object
+ * @param shared Address of the word
+ * @return Index of the stripe
+**/
+static inline int find_lock(const struct shared_lock_t* lock, const void* shared) {
+    return (int) ((((uintptr_t)shared - lock->base) >> lock->shift) & lock->mask);
+}
 
-void shared_lock_versioned_spinlock_release(struct shared_lock_t* lock, const void* shared);
+/** Get the versioned spinlock of a stripe: an index in the table, or an offset in the header of the arena chunk of the word.
+ * @param lock   Global lock object
+ * @param stripe Index of the stripe
+ * @return Versioned spinlock of the stripe
+**/
+static inline struct versioned_spinlock_t* shared_lock_stripe(const struct shared_lock_t* lock, int stripe) {
+    uintptr_t chunk = (uintptr_t)stripe >> lock->chunk_stripe_bits; // Always 0 for the table
+    uintptr_t entry = ((uintptr_t)stripe & lock->chunk_stripe_mask) - lock->header_stripes;
+    return (struct versioned_spinlock_t*) ((uintptr_t)lock->locks + (chunk << lock->chunk_shift)) + (entry << lock->stride_shift);
+}
 
-void shared_lock_versioned_spinlock_update(struct shared_lock_t* lock, const void* shared, int version);
+static inline bool shared_lock_versioned_spinlock_try_acquire_stripe(struct shared_lock_t* lock, int stripe, uint64_t owner, uint64_t* word) {
+    return versioned_spinlock_try_acquire(shared_lock_stripe(lock, stripe), owner, word);
+}
 
-bool shared_lock_versioned_spinlock_validate(struct shared_lock_t* lock, const void* shared, int version);
+static inline void shared_lock_versioned_spinlock_release_stripe(struct shared_lock_t* lock, int stripe, uint64_t version) {
+    versioned_spinlock_release_with_version(shared_lock_stripe(lock, stripe), version);
+}
 
-void shared_lock_segment_lock_acquire(struct shared_lock_t* lock);
+static inline uint64_t shared_lock_versioned_spinlock_sample_stripe(struct shared_lock_t* lock, int stripe) {
+    return versioned_spinlock_sample(shared_lock_stripe(lock, stripe));
+}
 
-void shared_lock_segment_lock_release(struct shared_lock_t* lock);
+static inline bool shared_lock_versioned_spinlock_validate_stripe(struct shared_lock_t* lock, int stripe, uint64_t version) {
+    return versioned_spinlock_validate(shared_lock_stripe(lock, stripe), version);
+}
 
-void shared_lock_cleanup(struct shared_lock_t* lock);
\ No newline at end of file
+size_t shared_lock_versioned_spinlock_validate_stripes(struct shared_lock_t* lock, const int* stripes, size_t count, uint64_t version);
+
+size_t shared_lock_versioned_spinlock_validate_stripes_avx2(struct shared_lock_t* lock, const int* stripes, size_t count, uint64_t version); // private fn
+
+bool shared_lock_versioned_spinlock_sample_range(struct shared_lock_t* lock, int first, size_t count, uint64_t* newest);
+
+size_t shared_lock_versioned_spinlock_validate_range(struct shared_lock_t* lock, int first, size_t count, uint64_t version);
+
+void shared_lock_cleanup(struct shared_lock_t* lock);
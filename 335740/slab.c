@@ -0,0 +1,172 @@
+#include "slab.h"
+
+void slab_init(struct slab* slab, size_t align, struct arena* arena, const struct config* config) {
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        atomic_init(&slab->caches[i], NULL);
+    }
+    pthread_mutex_init(&slab->overflow_lock, NULL);
+    atomic_init(&slab->chunks, NULL);
+    slab->arena = arena;
+    slab->config = config;
+    slab->chunk_size = config->huge_pages != HUGE_PAGES_OFF && arena == NULL ? MAPPING_HUGE_PAGE_SIZE : SLAB_CHUNK_SIZE; // Arena chunks are advised already
+    slab->header = align > CACHE_LINE_SIZE ? align : CACHE_LINE_SIZE; // Segments start on a cache line boundary
+    slab->min_shift = __builtin_ctzl(slab->header);
+}
+
+/** Allocate a zeroed segment from the free lists of the calling thread.
+ * @param slab  Slab allocator
+ * @param size  Size of the segment (in bytes)
+ * @return Segment, aligned on a cache line (and on the alignment of the region), NULL when running out of memory
+**/
+void* slab_alloc(struct slab* slab, size_t size) {
+    int size_class = 0;
+    while (size_class < SLAB_NUM_CLASSES && ((size_t) 1 << (slab->min_shift + size_class)) < size) {
+        size_class++;
+    }
+    if (unlikely(size_class == SLAB_NUM_CLASSES)) {
+        return NULL;
+    }
+
+    int thread = thread_id_get();
+    struct slab_cache* cache = slab_cache_get(slab, thread);
+    if (unlikely(!cache)) {
+        return NULL;
+    }
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_lock(&slab->overflow_lock);
+    }
+
+    struct segment_node* node = cache->free[size_class];
+    if (unlikely(node == NULL)) {
+        if (unlikely(!slab_refill(slab, cache, size_class))) {
+            if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+                pthread_mutex_unlock(&slab->overflow_lock);
+            }
+            return NULL;
+        }
+        node = cache->free[size_class];
+    }
+    cache->free[size_class] = node->next;
+
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_unlock(&slab->overflow_lock);
+    }
+
+    void* segment = (void*) ((uintptr_t) node + slab->header);
+    memset(segment, 0, size);
+    return segment;
+}
+
+/** Give a segment no transaction can access anymore back to the free lists of the calling thread.
+ * @param slab  Slab allocator
+ * @param node  Header of the segment
+**/
+void slab_recycle(struct slab* slab, struct segment_node* node) {
+    int thread = thread_id_get();
+    struct slab_cache* cache = slab_cache_get(slab, thread);
+    if (unlikely(!cache)) { // The segment stays unused until its chunk is freed with the slab
+        return;
+    }
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_lock(&slab->overflow_lock);
+    }
+
+    node->next = cache->free[node->size_class];
+    cache->free[node->size_class] = node;
+
+    if (unlikely(thread == THREAD_ID_OVERFLOW)) {
+        pthread_mutex_unlock(&slab->overflow_lock);
+    }
+}
+
+/** Get the free lists of a thread, allocating them at its first use of the slab.
+ * @param slab      Slab allocator
+ * @param thread    Id of the calling thread
+ * @return Free lists of the thread, NULL when running out of memory
+**/
+struct slab_cache* slab_cache_get(struct slab* slab, int thread) {
+    struct slab_cache* cache = atomic_load_explicit(&slab->caches[thread], memory_order_acquire);
+    if (likely(cache != NULL)) {
+        return cache;
+    }
+
+    cache = (struct slab_cache*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct slab_cache));
+    if (unlikely(!cache)) {
+        return NULL;
+    }
+    for (int i = 0; i < SLAB_NUM_CLASSES; i++) {
+        cache->free[i] = NULL;
+    }
+    struct slab_cache* expected = NULL;
+    if (!atomic_compare_exchange_strong(&slab->caches[thread], &expected, cache)) { // Only threads beyond THREAD_ID_MAX race for it
+        free(cache);
+        cache = expected;
+    }
+    return cache;
+}
+
+/** Allocate a chunk, register it, and carve it into segments of a size class for the free list of a thread.
+ * @param slab          Slab allocator
+ * @param cache         Free lists of the calling thread
+ * @param size_class    Size class of the empty free list
+ * @return Whether the free list got at least one segment
+**/
+bool slab_refill(struct slab* slab, struct slab_cache* cache, int size_class) {
+    size_t stride = slab->header + ((size_t) 1 << (slab->min_shift + size_class));
+    size_t count = (slab->chunk_size - slab->header) / stride; // Large classes get a chunk of their own
+    if (count == 0) {
+        count = 1;
+    }
+
+    struct slab_chunk* chunk;
+    if (slab->arena != NULL) { // Segments larger than the data part of an arena chunk cannot be allocated
+        chunk = (struct slab_chunk*) arena_alloc(slab->arena, slab->header + count * stride);
+        if (unlikely(!chunk)) {
+            return false;
+        }
+    }
+    else {
+        size_t mapping = slab->header + count * stride;
+        if (mapping_enabled(slab->config)) {
+            chunk = (struct slab_chunk*) mapping_alloc(&mapping, slab->header, slab->config);
+        }
+        else {
+            chunk = (struct slab_chunk*) aligned_alloc(slab->header, mapping);
+            mapping = 0;
+        }
+        if (unlikely(!chunk)) {
+            return false;
+        }
+        chunk->mapping = mapping;
+
+        chunk->next = atomic_load_explicit(&slab->chunks, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak(&slab->chunks, &chunk->next, chunk)); // Lock-free push, chunks are never unregistered
+    }
+
+    for (size_t i = count; i-- > 0;) { // Lowest addresses first in the list
+        struct segment_node* node = (struct segment_node*) ((uintptr_t) chunk + slab->header + i * stride);
+        node->size_class = size_class;
+        node->next = cache->free[size_class];
+        cache->free[size_class] = node;
+    }
+    return true;
+}
+
+void slab_cleanup(struct slab* slab) {
+    struct slab_chunk* chunk = atomic_load(&slab->chunks);
+    while (chunk != NULL) {
+        struct slab_chunk* next = chunk->next;
+        if (chunk->mapping > 0) {
+            mapping_free(chunk, chunk->mapping);
+        }
+        else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    atomic_store(&slab->chunks, NULL);
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        free(atomic_load(&slab->caches[i]));
+    }
+    pthread_mutex_destroy(&slab->overflow_lock);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "config.h"
+#include "macros.h"
+#include "mapping.h"
+#include "thread-id.h"
+
+#define SLAB_NUM_CLASSES 32          // Size classes, each twice as large as the previous one, the first one being a header
+#define SLAB_CHUNK_SIZE (64 * 1024)  // Size of the chunks carved into segments of the small classes (in bytes, a huge page with huge pages)
+
+/**
+ * @brief Header placed before every segment, linking it in a free list or a limbo list.
+ */
+struct segment_node {
+    struct segment_node* next; // Next segment of the free list or of the limbo list holding it
+    uint64_t retired_at;       // Clock value after the commit that freed it, once retired
+    int size_class;
+};
+
+/**
+ * @brief Header of a chunk of memory carved into segments of one size class, in the registry of the slab.
+ */
+struct slab_chunk {
+    struct slab_chunk* next; // Chunk registered before (never changes once registered)
+    size_t mapping;          // Size of the mapping holding the chunk (0 if it is on the heap)
+};
+
+/**
+ * @brief Free segments of one thread, one list per size class, alone on its cache lines.
+ */
+struct slab_cache {
+    struct segment_node* free[SLAB_NUM_CLASSES];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Per-thread size-class allocator of the segments of a region. Memory is only returned on destruction:
+ * freed segments go back to the free lists of the thread that recycles them.
+ */
+struct slab {
+    struct slab_cache* _Atomic caches[THREAD_ID_MAX + 1]; // Indexed by thread id, allocated at the first allocation or recycling of the thread
+    pthread_mutex_t overflow_lock;               // Serializes the threads sharing the cache of THREAD_ID_OVERFLOW
+    struct slab_chunk* _Atomic chunks;           // Every chunk allocated so far, only walked on destruction
+    struct arena* arena;                         // Arena the chunks are carved from, and freed with (NULL for the heap or mappings)
+    const struct config* config;                 // Huge pages and NUMA placement of the chunks mapped outside of an arena
+    size_t chunk_size;                           // Size of the chunks carved into segments of the small classes (in bytes)
+    size_t header;                               // Space before every segment (in bytes), a multiple of the alignment and of a cache line
+    int min_shift;                               // Log2 of the size of the smallest class, at least the header size
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+void slab_init(struct slab* slab, size_t align, struct arena* arena, const struct config* config);
+
+void* slab_alloc(struct slab* slab, size_t size);
+
+void slab_recycle(struct slab* slab, struct segment_node* node);
+
+/** Get the header of a segment.
+ * @param slab      Slab allocator
+ * @param segment   Segment allocated by the slab
+ * @return Header of the segment
+**/
+static inline struct segment_node* slab_node(const struct slab* slab, void* segment) {
+    return (struct segment_node*) ((uintptr_t) segment - slab->header);
+}
+
+struct slab_cache* slab_cache_get(struct slab* slab, int thread); // private fn
+
+bool slab_refill(struct slab* slab, struct slab_cache* cache, int size_class); // private fn
+
+void slab_cleanup(struct slab* slab);
@@ -0,0 +1,78 @@
+#include "snapshot-registry.h"
+
+static _Thread_local size_t hint = 0; // Slot this thread claimed last, most likely free again
+
+void snapshot_registry_init(struct snapshot_registry* registry) {
+    for (size_t i = 0; i < SNAPSHOT_REGISTRY_SLOTS; i++) {
+        atomic_store(&registry->slots[i].snapshot, SNAPSHOT_IDLE);
+    }
+    atomic_store(&registry->high_water, 0);
+    atomic_store(&registry->overflow, 0);
+}
+
+/** Claim a slot and announce a snapshot in it.
+ * @param registry  Snapshot registry
+ * @param clock     Clock the snapshot is taken from
+ * @param snapshot  Receives the snapshot, never older than the announced one
+ * @return Index of the claimed slot, SNAPSHOT_REGISTRY_OVERFLOW if every slot is in use (the caller is then only counted)
+**/
+int snapshot_registry_enter(struct snapshot_registry* registry, struct global_clock* clock, uint64_t* snapshot) {
+    uint64_t announced = global_clock_sample(clock);
+    for (size_t i = 0; i < SNAPSHOT_REGISTRY_SLOTS; i++) {
+        size_t slot = (hint + i) % SNAPSHOT_REGISTRY_SLOTS;
+        uint64_t idle = SNAPSHOT_IDLE;
+        if (atomic_load_explicit(&registry->slots[slot].snapshot, memory_order_relaxed) == SNAPSHOT_IDLE
+                && atomic_compare_exchange_strong(&registry->slots[slot].snapshot, &idle, announced)) {
+            size_t high_water = atomic_load(&registry->high_water);
+            while (high_water <= slot && !atomic_compare_exchange_weak(&registry->high_water, &high_water, slot + 1));
+
+            hint = slot;
+            // Sampling again after announcing guarantees that a writer who missed the announcement
+            // sampled the clock before us, so it cannot discard anything this snapshot needs.
+            *snapshot = global_clock_sample(clock);
+            return (int) slot;
+        }
+    }
+
+    atomic_fetch_add(&registry->overflow, 1);
+    *snapshot = global_clock_sample(clock);
+    return SNAPSHOT_REGISTRY_OVERFLOW;
+}
+
+void snapshot_registry_leave(struct snapshot_registry* registry, int slot) {
+    if (unlikely(slot == SNAPSHOT_REGISTRY_OVERFLOW)) {
+        atomic_fetch_sub_explicit(&registry->overflow, 1, memory_order_release);
+        return;
+    }
+    atomic_store_explicit(&registry->slots[slot].snapshot, SNAPSHOT_IDLE, memory_order_release);
+}
+
+/** Get the oldest snapshot any running or future transaction may use.
+ * @param registry  Snapshot registry
+ * @param clock     Clock the snapshots are taken from
+ * @return Oldest snapshot in use
+**/
+uint64_t snapshot_registry_oldest(struct snapshot_registry* registry, struct global_clock* clock) {
+    uint64_t oldest = global_clock_sample(clock); // Transactions not announced yet will use a newer snapshot
+    size_t high_water = atomic_load(&registry->high_water);
+    for (size_t i = 0; i < high_water; i++) {
+        uint64_t snapshot = atomic_load(&registry->slots[i].snapshot);
+        if (snapshot < oldest) {
+            oldest = snapshot;
+        }
+    }
+    return oldest;
+}
+
+/** Get the oldest clock value any running or future transaction began at, counted transactions included.
+ * @param registry  Snapshot registry
+ * @param clock     Clock the snapshots are taken from
+ * @return Oldest begin time, 0 while some transaction runs without a slot
+**/
+uint64_t snapshot_registry_oldest_begin(struct snapshot_registry* registry, struct global_clock* clock) {
+    uint64_t oldest = snapshot_registry_oldest(registry, clock);
+    if (atomic_load(&registry->overflow) != 0) { // Its begin time is unknown
+        return 0;
+    }
+    return oldest;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "global-clock.h"
+#include "macros.h"
+
+#define SNAPSHOT_REGISTRY_SLOTS 256    // Maximum number of concurrently announced snapshots
+#define SNAPSHOT_IDLE UINT64_MAX       // Value of a slot announcing no snapshot
+#define SNAPSHOT_REGISTRY_OVERFLOW SNAPSHOT_REGISTRY_SLOTS // Slot of the transactions that found every slot in use
+
+/**
+ * @brief Slot announcing the snapshot of one running transaction, alone on its cache line.
+ */
+struct snapshot_slot {
+    _Atomic uint64_t snapshot;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Snapshots announced by running transactions, so that writers know which old data may still be read.
+ */
+struct snapshot_registry {
+    struct snapshot_slot slots[SNAPSHOT_REGISTRY_SLOTS];
+    _Atomic size_t high_water; // Slots past this one have never been claimed
+    _Atomic size_t overflow __attribute__((aligned(CACHE_LINE_SIZE))); // Running transactions that found every slot in use
+};
+
+void snapshot_registry_init(struct snapshot_registry* registry);
+
+int snapshot_registry_enter(struct snapshot_registry* registry, struct global_clock* clock, uint64_t* snapshot);
+
+void snapshot_registry_leave(struct snapshot_registry* registry, int slot);
+
+uint64_t snapshot_registry_oldest(struct snapshot_registry* registry, struct global_clock* clock);
+
+uint64_t snapshot_registry_oldest_begin(struct snapshot_registry* registry, struct global_clock* clock);
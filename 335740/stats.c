@@ -0,0 +1,118 @@
+#include "stats.h"
+
+#ifdef TM_STATS // Nothing is collected otherwise
+
+static const char* const abort_cause_names[TM_NUM_ABORT_CAUSES] = { "read-locked", "read-validation", "write-locked", "commit-validation", "no-memory" };
+
+void stats_init(struct stats* stats) {
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        stats_kind_init(&stats->threads[i].ro);
+        stats_kind_init(&stats->threads[i].rw);
+        atomic_init(&stats->threads[i].validation_skips, 0);
+    }
+}
+
+/** Count a committed transaction in the counters of the calling thread.
+ * @param stats     Statistics of the region
+ * @param is_ro     Whether the transaction is read-only
+ * @param reads     Size of its read set
+ * @param writes    Number of words it wrote
+**/
+void stats_commit(struct stats* stats, bool is_ro, size_t reads, size_t writes) {
+    struct thread_stats* thread = &stats->threads[thread_id_get()];
+    struct kind_stats* kind = is_ro ? &thread->ro : &thread->rw;
+    // Relaxed increments, atomic only because the threads beyond THREAD_ID_MAX share a slot
+    atomic_fetch_add_explicit(&kind->commits, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&kind->read_set_sizes[stats_bucket(reads)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&kind->write_set_sizes[stats_bucket(writes)], 1, memory_order_relaxed);
+}
+
+/** Count an aborted transaction in the counters of the calling thread.
+ * @param stats Statistics of the region
+ * @param is_ro Whether the transaction is read-only
+ * @param cause Reason of the abort
+**/
+void stats_abort(struct stats* stats, bool is_ro, enum tm_abort_cause cause) {
+    struct thread_stats* thread = &stats->threads[thread_id_get()];
+    struct kind_stats* kind = is_ro ? &thread->ro : &thread->rw;
+    atomic_fetch_add_explicit(&kind->aborts[cause], 1, memory_order_relaxed);
+}
+
+void stats_validation_skip(struct stats* stats) {
+    atomic_fetch_add_explicit(&stats->threads[thread_id_get()].validation_skips, 1, memory_order_relaxed);
+}
+
+/** Sum up the counters of every thread (running transactions may still be counting).
+ * @param stats Statistics of the region
+ * @param total Receives the sums
+**/
+void stats_collect(struct stats* stats, struct tm_stats* total) {
+    memset(total, 0, sizeof(struct tm_stats));
+    size_t high_water = thread_id_high_water();
+    for (size_t i = 0; i <= THREAD_ID_MAX; i++) {
+        if (i >= high_water && i != THREAD_ID_OVERFLOW) { // Never given out
+            continue;
+        }
+        stats_kind_collect(&stats->threads[i].ro, &total->ro);
+        stats_kind_collect(&stats->threads[i].rw, &total->rw);
+        total->validation_skips += atomic_load_explicit(&stats->threads[i].validation_skips, memory_order_relaxed);
+    }
+}
+
+void stats_dump(const struct tm_stats* total, FILE* stream) {
+    stats_kind_dump("ro", &total->ro, stream);
+    stats_kind_dump("rw", &total->rw, stream);
+    fprintf(stream, "tm stats: rw validation skips %lu\n", (unsigned long) total->validation_skips);
+}
+
+/** Get the histogram bucket of a set size.
+ * @param size Set size
+ * @return 0 for an empty set, 1 + log2 of the size otherwise (the last bucket taking every larger size)
+**/
+int stats_bucket(size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzl(size);
+    return bucket < TM_STATS_BUCKETS ? bucket : TM_STATS_BUCKETS - 1;
+}
+
+void stats_kind_init(struct kind_stats* kind) {
+    atomic_init(&kind->commits, 0);
+    for (int i = 0; i < TM_NUM_ABORT_CAUSES; i++) {
+        atomic_init(&kind->aborts[i], 0);
+    }
+    for (int i = 0; i < TM_STATS_BUCKETS; i++) {
+        atomic_init(&kind->read_set_sizes[i], 0);
+        atomic_init(&kind->write_set_sizes[i], 0);
+    }
+}
+
+void stats_kind_collect(struct kind_stats* kind, struct tm_stats_kind* total) {
+    total->commits += atomic_load_explicit(&kind->commits, memory_order_relaxed);
+    for (int i = 0; i < TM_NUM_ABORT_CAUSES; i++) {
+        total->aborts[i] += atomic_load_explicit(&kind->aborts[i], memory_order_relaxed);
+    }
+    for (int i = 0; i < TM_STATS_BUCKETS; i++) {
+        total->read_set_sizes[i] += atomic_load_explicit(&kind->read_set_sizes[i], memory_order_relaxed);
+        total->write_set_sizes[i] += atomic_load_explicit(&kind->write_set_sizes[i], memory_order_relaxed);
+    }
+}
+
+void stats_kind_dump(const char* name, const struct tm_stats_kind* total, FILE* stream) {
+    fprintf(stream, "tm stats: %s commits %lu, aborts", name, (unsigned long) total->commits);
+    for (int i = 0; i < TM_NUM_ABORT_CAUSES; i++) {
+        fprintf(stream, " %s %lu", abort_cause_names[i], (unsigned long) total->aborts[i]);
+    }
+    fprintf(stream, "\ntm stats: %s read set sizes", name);
+    for (int i = 0; i < TM_STATS_BUCKETS; i++) {
+        fprintf(stream, " %lu", (unsigned long) total->read_set_sizes[i]);
+    }
+    fprintf(stream, "\ntm stats: %s write set sizes", name);
+    for (int i = 0; i < TM_STATS_BUCKETS; i++) {
+        fprintf(stream, " %lu", (unsigned long) total->write_set_sizes[i]);
+    }
+    fprintf(stream, "\n");
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tm-stats.h>
+#include "macros.h"
+#include "thread-id.h"
+
+/** Compile a statement only if the library collects statistics (built with -DTM_STATS).
+ * @param statement Statement updating or reading the statistics
+**/
+#undef STATS
+#ifdef TM_STATS
+    #define STATS(statement) statement
+#else
+    #define STATS(statement)
+#endif
+
+/**
+ * @brief Counters of the transactions of one kind (read-only or read-write) run by a thread.
+ */
+struct kind_stats {
+    _Atomic uint64_t commits;
+    _Atomic uint64_t aborts[TM_NUM_ABORT_CAUSES];
+    _Atomic uint64_t read_set_sizes[TM_STATS_BUCKETS];
+    _Atomic uint64_t write_set_sizes[TM_STATS_BUCKETS];
+};
+
+/**
+ * @brief Counters of one thread, on cache lines of their own so that counting never bounces a line between threads.
+ */
+struct thread_stats {
+    struct kind_stats ro;
+    struct kind_stats rw;
+    _Atomic uint64_t validation_skips;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+ * @brief Statistics of a region, counted per thread and only summed up when queried.
+ */
+struct stats {
+    struct thread_stats threads[THREAD_ID_MAX + 1]; // Indexed by thread id, THREAD_ID_OVERFLOW shared by the threads beyond
+};
+
+void stats_init(struct stats* stats);
+
+void stats_commit(struct stats* stats, bool is_ro, size_t reads, size_t writes);
+
+void stats_abort(struct stats* stats, bool is_ro, enum tm_abort_cause cause);
+
+void stats_validation_skip(struct stats* stats);
+
+void stats_collect(struct stats* stats, struct tm_stats* total);
+
+void stats_dump(const struct tm_stats* total, FILE* stream);
+
+int stats_bucket(size_t size); // private fn
+
+void stats_kind_init(struct kind_stats* kind); // private fn
+
+void stats_kind_collect(struct kind_stats* kind, struct tm_stats_kind* total); // private fn
+
+void stats_kind_dump(const char* name, const struct tm_stats_kind* total, FILE* stream); // private fn
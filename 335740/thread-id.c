@@ -0,0 +1,53 @@
+#include "thread-id.h"
+
+static pthread_key_t id_key;
+static pthread_once_t id_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+static int free_ids[THREAD_ID_MAX];  // Ids released by exited threads
+static size_t num_free_ids = 0;
+static _Atomic size_t high_water = 0; // Ids past this one were never given out
+static _Thread_local int id = -1;
+
+static void id_key_create(void) {
+    pthread_key_create(&id_key, thread_id_release);
+}
+
+/** Get the id of the calling thread, small and dense so that it can index per-thread arrays.
+ * @return Id of the thread, 'THREAD_ID_OVERFLOW' if all ids are taken
+**/
+int thread_id_get(void) {
+    if (likely(id >= 0)) {
+        return id;
+    }
+
+    pthread_once(&id_key_once, id_key_create);
+    pthread_mutex_lock(&id_lock);
+    if (num_free_ids > 0) {
+        id = free_ids[--num_free_ids];
+    }
+    else if (atomic_load(&high_water) < THREAD_ID_MAX) {
+        id = (int) atomic_fetch_add(&high_water, 1);
+    }
+    else {
+        id = THREAD_ID_OVERFLOW;
+    }
+    pthread_mutex_unlock(&id_lock);
+
+    if (id != THREAD_ID_OVERFLOW) {
+        pthread_setspecific(id_key, &id); // Any non-NULL value so that the id is given back on thread exit
+    }
+    return id;
+}
+
+/** Get the number of ids ever given out (every id is below it).
+**/
+size_t thread_id_high_water(void) {
+    return atomic_load(&high_water);
+}
+
+void thread_id_release(void* unused(value)) {
+    pthread_mutex_lock(&id_lock);
+    free_ids[num_free_ids++] = id;
+    pthread_mutex_unlock(&id_lock);
+    id = -1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "macros.h"
+
+#define THREAD_ID_MAX 1024 // Number of distinct thread ids, threads beyond it get THREAD_ID_OVERFLOW
+#define THREAD_ID_OVERFLOW THREAD_ID_MAX
+
+int thread_id_get(void);
+
+size_t thread_id_high_water(void);
+
+void thread_id_release(void* value); // private fn
@@ -34,93 +34,907 @@
 
 // Internal headers
 #include <tm.h>
+#include <tm-stats.h>
+#include "arena.h"
+#include "config.h"
+#include "contention-manager.h"
+#include "irrevocability.h"
 #include "macros.h"
+#include "mapping.h"
+#include "profiler.h"
+#include "reclamation.h"
 #include "shared-lock.h"
+#include "slab.h"
+#include "snapshot-registry.h"
+#include "stats.h"
+#include "thread-id.h"
 #include "transaction.h"
+#include "version-chain.h"
+
+struct region;
 
 /**
- * @brief List of dynamically allocated segments.
+ * @brief Per-word paths of the engine, compiled once for every common word size so that each word is a native load or store.
  */
-struct segment_node {
-    struct segment_node* prev;
-    struct segment_node* next;
+struct word_ops {
+    bool (*read)(struct region*, struct transaction*, const void*, size_t, void*);
+    bool (*write)(struct region*, struct transaction*, const void*, size_t, void*);
 };
-typedef struct segment_node* segment_list;
 
 /**
  * @brief Simple Shared Memory Region (a.k.a Transactional Memory).
  */
 struct region {
     struct shared_lock_t lock;  // Global lock
+    struct config config;       // Tunables read from the environment at creation
+    struct snapshot_registry* snapshots; // Begin times of the running transactions (multi-version engine or reclamation only)
+    struct version_chains versions;      // Old versions of the words of every stripe (multi-version engine only)
+    struct irrevocability* irrevocability; // Token of the irrevocable transaction (NULL if disabled)
+    struct arena* arena;                     // Arena holding every segment next to its locks (NULL with a lock table)
+    struct slab* _Atomic slab;               // Allocator of the segments of tm_alloc (NULL until the first allocation)
+    struct reclamation* _Atomic reclamation; // Limbo lists of the freed segments (NULL until the first free)
     void* start;                // Start of the shared memory region (i.e., of the non-deallocable memory segment)
-    segment_list allocs;        // Shared memory segments dynamically allocated via tm_alloc within transactions
+    size_t start_mapping;       // Size of the mapping holding the first segment (0 if it is on the heap or in the arena)
     size_t size;                // Size of the non-deallocable memory segment (in bytes)
     size_t align;               // Size of a word in the shared memory region (in bytes)
+    const struct word_ops* ops; // Read and write paths specialized for that word size
+#ifdef TM_STATS
+    struct stats* stats;        // Commit and abort counters of every thread
+#endif
+#ifdef TM_PROFILE
+    struct profiler* profiler;  // Samples of the conflicts aborting transactions
+#endif
 };
 
 
 
 // Start of helper functions used to implement TL2
 
-/** Unlock the written memory addresses.
- * @param lock              Global lock object stored in region
- * @param first_write_node  Pointer to the write node which contains the first memory address that needs to be unlocked
- * @param next_to_lock      Pointer to the write node which contains the last memory address that needs to be unlocked
- *                          -(NULL if all addresses stored in write set need to be unlocked)
+/** Unlock the stripes of the written memory addresses, restoring the versions they had before being locked.
+ * @param lock          Global lock object stored in region
+ * @param lock_set      Distinct stripes of the write set
+ * @param num_locked    Number of stripes (from the start of the lock set) that need to be unlocked
 **/
-void unlock_write_set(struct shared_lock_t* lock, struct write_node* first_write_node, struct write_node* next_to_lock) {
-    while (first_write_node != next_to_lock) {
-        shared_lock_versioned_spinlock_release(lock, first_write_node->address);
-        first_write_node = first_write_node->next; 
+void unlock_write_set(struct shared_lock_t* lock, const struct lock_set* lock_set, size_t num_locked) {
+    for (size_t i = 0; i < num_locked; i++) {
+        shared_lock_versioned_spinlock_release_stripe(lock, lock_set->stripes[i], lock_set->versions[i]);
     }
 }
 
-/** Lock the written memory addresses.
- * @param lock              Global lock object stored in region
- * @param first_write_node  Pointer to the write node which contains the first memory address that needs to be locked
- * @return Whether the all the written addresses were locked successfully or not
+/** Lock the stripes of the written memory addresses, each one once and in ascending order.
+ * @param lock          Global lock object stored in region
+ * @param policy        Contention policy deciding how long to wait for stripes locked by other transactions
+ * @param lock_set      Lock set holding the distinct stripes of the write set, receiving their versions before locking
+ * @param work          Work (accesses) of the transaction, weighing in its priority
+ * @param floor         Receives the largest version the stripes had before locking
+ * @return Position in the lock set of the stripe that could not be locked (the ones before it being unlocked again), its size if all were locked
 **/
-bool lock_write_set(struct shared_lock_t* lock, struct write_node* first_write_node) {
-    struct write_node* begin = first_write_node;
-    while (first_write_node != NULL) {
-        if (!shared_lock_versioned_spinlock_acquire(lock, first_write_node->address)) {
-            unlock_write_set(lock, begin, first_write_node);
-            return false;
+size_t lock_write_set(struct shared_lock_t* lock, enum contention_policy policy, struct lock_set* lock_set, size_t work, uint64_t* floor) {
+    int thread = thread_id_get();
+    *floor = 0;
+    for (size_t i = 0; i < lock_set->size; i++) {
+        uint64_t holder = VERSIONED_SPINLOCK_HOLDER(thread, i);
+        for (unsigned round = 0; !shared_lock_versioned_spinlock_try_acquire_stripe(lock, lock_set->stripes[i], holder, &lock_set->versions[i]); round++) {
+            if (!contention_wait(policy, VERSIONED_SPINLOCK_THREAD(lock_set->versions[i]), round, work)) {
+                unlock_write_set(lock, lock_set, i);
+                return i;
+            }
+        }
+        if (lock_set->versions[i] > *floor) {
+            *floor = lock_set->versions[i];
         }
-        first_write_node = first_write_node->next;
     }
-    return true;
+    return lock_set->size;
 }
 
 /** Validate the read memory addresses.
- * @param lock              Global lock object stored in region
- * @param first_read_node  Pointer to the read node which contains the first memory address that needs to be validated
- * @param rv                Read version (according to TL2 algorithm)
+ * @param lock      Global lock object stored in region
+ * @param read_set  Read set holding the lock stripes of every read memory address, and the stripe runs of the ranges read at once
+ * @param lock_set  Stripes locked by the transaction, whose versions before locking are validated instead
+ * @param rv        Read version (according to TL2 algorithm)
  * @return Whether the all the read addresses were validated successfully or not
 **/
-bool validate_read_set(struct shared_lock_t* lock, struct read_node* first_read_node, int rv) {
-    while (first_read_node != NULL) {
-        if (!shared_lock_versioned_spinlock_validate(lock, first_read_node->address, rv)) {
+bool validate_read_set(struct shared_lock_t* lock, const struct read_set* read_set, const struct lock_set* lock_set, uint64_t rv) {
+    size_t validated = 0;
+    while (true) {
+        validated += shared_lock_versioned_spinlock_validate_stripes(lock, read_set->stripes + validated, read_set->size - validated, rv);
+        if (validated == read_set->size) {
+            break;
+        }
+
+        int stripe = read_set->stripes[validated];
+        uint64_t version;
+        if (!lock_set_owns(lock_set, shared_lock_versioned_spinlock_sample_stripe(lock, stripe), stripe, &version) || version > rv) { // Locked by another transaction, or newer
             return false;
         }
-        first_read_node = first_read_node->next;
+        validated++;
+    }
+
+    for (size_t i = 0; i < read_set->num_ranges; i++) {
+        const struct read_range* range = &read_set->ranges[i];
+        for (size_t validated = 0; true; validated++) {
+            validated += shared_lock_versioned_spinlock_validate_range(lock, range->first + (int) validated, range->count - validated, rv);
+            if (validated == (size_t) range->count) {
+                break;
+            }
+
+            int stripe = (int) ((range->first + validated) & lock->mask);
+            uint64_t version;
+            if (!lock_set_owns(lock_set, shared_lock_versioned_spinlock_sample_stripe(lock, stripe), stripe, &version) || version > rv) {
+                return false;
+            }
+        }
     }
     return true;
 }
 
-/** Store the written data to the shared memory region.
- * @param lock              Global lock object stored in region
- * @param first_write_node  Pointer to the write node which contains the first memory address and the value written to it
- * @param size              Size of the memory region to be copied (equal to the alignment of the region)
- * @param wv                Write version (according to TL2 algorithm)
+#ifdef TM_PROFILE
+/** Tell whether a stripe read by a transaction still validates (profiled builds only).
+ * @param region        Shared memory region
+ * @param transaction   Transaction that read the stripe
+ * @param stripe        Index of the stripe
+ * @return Whether the stripe is unlocked (or held by the transaction) with a version the snapshot covers
+**/
+bool profile_stripe_valid(struct region* region, const struct transaction* transaction, int stripe) {
+    uint64_t word = shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe);
+    uint64_t version;
+    return word <= transaction->rv || (lock_set_owns(&transaction->lock_set, word, stripe, &version) && version <= transaction->rv);
+}
+
+/** Tell whether a stripe is held by another transaction (profiled builds only).
+ * @param region        Shared memory region
+ * @param transaction   Transaction that met the stripe
+ * @param stripe        Index of the stripe
+ * @return Whether the stripe is locked, and not by the transaction
 **/
-void store_write_set(struct shared_lock_t* lock, struct write_node* first_write_node, size_t size, int wv) {
-    while (first_write_node != NULL) {
-        memcpy(first_write_node->address, first_write_node->value, size);
-        shared_lock_versioned_spinlock_update(lock, first_write_node->address, wv);
-        shared_lock_versioned_spinlock_release(lock, first_write_node->address);
-        first_write_node = first_write_node->next;
+bool profile_stripe_held(struct region* region, const struct transaction* transaction, int stripe) {
+    uint64_t word = shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe);
+    uint64_t version;
+    return (word & VERSIONED_SPINLOCK_LOCKED) && !lock_set_owns(&transaction->lock_set, word, stripe, &version);
+}
+
+/** Sample a word that changed under its stripe while it was read, telling whether the word itself changed (profiled builds only).
+ * @param region        Shared memory region
+ * @param transaction   Transaction reading the word
+ * @param stripe        Index of the stripe of the word
+ * @param address       Address of the word
+ * @param since         Version of the stripe when the word was read
+**/
+void profile_conflict(struct region* region, const struct transaction* transaction, int stripe, const void* address, uint64_t since) {
+    enum conflict_class class = profiler_shadow_check(region->profiler, address, since);
+    if (class != CONFLICT_TRUE && profile_stripe_held(region, transaction, stripe)) {
+        class = CONFLICT_HELD;
     }
+    profiler_record(region->profiler, stripe, address, class);
+}
+
+/** Sample the first stripe failing validation in the read set of a transaction, telling whether a word read under it changed (profiled builds only).
+ * @param region        Shared memory region
+ * @param transaction   Transaction whose read set just failed validation
+**/
+void profile_validation(struct region* region, const struct transaction* transaction) {
+    const struct read_set* read_set = &transaction->read_set;
+    int stripe = -1;
+    const void* address = NULL;
+    for (size_t i = 0; i < read_set->size && stripe < 0; i++) {
+        if (!profile_stripe_valid(region, transaction, read_set->stripes[i])) {
+            stripe = read_set->stripes[i];
+            address = read_set->addresses[i];
+        }
+    }
+    for (size_t i = 0; i < read_set->num_ranges && stripe < 0; i++) {
+        const struct read_range* range = &read_set->ranges[i];
+        for (size_t offset = 0; offset < range->size && stripe < 0; offset += region->align) {
+            if (!profile_stripe_valid(region, transaction, find_lock(&region->lock, range->source + offset))) {
+                stripe = find_lock(&region->lock, range->source + offset);
+                address = range->source + offset;
+            }
+        }
+    }
+    if (stripe < 0) { // Released since with its old version (the holder aborted)
+        return;
+    }
+
+    // Every word read under the stripe was consistent with the snapshot, so any of them written since is a true conflict
+    enum conflict_class class = CONFLICT_FALSE;
+    for (size_t i = 0; i < read_set->size; i++) {
+        if (read_set->stripes[i] == stripe) {
+            enum conflict_class word_class = profiler_shadow_check(region->profiler, read_set->addresses[i], transaction->rv);
+            if (word_class == CONFLICT_TRUE) {
+                profiler_record(region->profiler, stripe, read_set->addresses[i], CONFLICT_TRUE);
+                return;
+            }
+            class = word_class == CONFLICT_UNKNOWN ? CONFLICT_UNKNOWN : class;
+        }
+    }
+    for (size_t i = 0; i < read_set->num_ranges; i++) {
+        const struct read_range* range = &read_set->ranges[i];
+        for (size_t offset = 0; offset < range->size; offset += region->align) {
+            if (find_lock(&region->lock, range->source + offset) == stripe) {
+                enum conflict_class word_class = profiler_shadow_check(region->profiler, range->source + offset, transaction->rv);
+                if (word_class == CONFLICT_TRUE) {
+                    profiler_record(region->profiler, stripe, range->source + offset, CONFLICT_TRUE);
+                    return;
+                }
+                class = word_class == CONFLICT_UNKNOWN ? CONFLICT_UNKNOWN : class;
+            }
+        }
+    }
+    profiler_record(region->profiler, stripe, address, profile_stripe_held(region, transaction, stripe) ? CONFLICT_HELD : class);
+}
+
+/** Sample a stripe of the write set that could not be locked, with a word written under it (profiled builds only).
+ * @param region        Shared memory region
+ * @param write_set     Write set of the transaction
+ * @param stripe        Index of the stripe
+**/
+void profile_write_conflict(struct region* region, const struct write_set* write_set, int stripe) {
+    const void* address = NULL;
+    for (size_t i = 0; i < write_set->size && address == NULL; i++) {
+        if (find_lock(&region->lock, write_set_entry(write_set, i)->address) == stripe) {
+            address = write_set_entry(write_set, i)->address;
+        }
+    }
+    profiler_record(region->profiler, stripe, address, CONFLICT_HELD);
+}
+
+/** Stamp the shadow versions of the words written by a committing transaction, whose stripes are still held (profiled builds only).
+ * @param region        Shared memory region
+ * @param transaction   Committing read-write transaction
+ * @param wv            Write version of the commit
+**/
+void profile_commit(struct region* region, const struct transaction* transaction, uint64_t wv) {
+    for (size_t i = 0; i < transaction->write_set.size; i++) {
+        profiler_shadow_store(region->profiler, write_set_entry(&transaction->write_set, i)->address, wv);
+    }
+    for (size_t i = 0; i < transaction->undo_log.size; i++) {
+        profiler_shadow_store(region->profiler, undo_log_entry(&transaction->undo_log, i)->address, wv);
+    }
+}
+#endif
+
+/** Extend the snapshot of a transaction to the current global clock (timestamp extension), if nothing it read has changed since.
+ * @param lock          Global lock object stored in region
+ * @param transaction   Transaction whose read version is extended
+ * @return Whether the read version could be extended
+**/
+bool extend_snapshot(struct shared_lock_t* lock, struct transaction* transaction) {
+    uint64_t rv = shared_lock_global_clock_get(lock); // Sample first, so that every version validated below is covered
+    if (!validate_read_set(lock, &transaction->read_set, &transaction->lock_set, transaction->rv)) {
+        return false;
+    }
+    transaction->rv = rv;
+    return true;
+}
+
+/** Save the values a commit is about to overwrite, and reclaim the old versions no snapshot can read anymore (multi-version engine).
+ * @param region        Shared memory region
+ * @param write_set     Write set holding the memory addresses about to be overwritten
+ * @param lock_set      Distinct stripes of the write set, all locked
+ * @param wv            Write version (according to TL2 algorithm)
+ * @return Whether every old version could be saved
+**/
+bool save_old_versions(struct region* region, const struct write_set* write_set, const struct lock_set* lock_set, uint64_t wv) {
+    for (size_t i = 0; i < write_set->size; i++) {
+        void* address = write_set_entry(write_set, i)->address;
+        if (unlikely(!version_chains_push(&region->versions, find_lock(&region->lock, address), address, wv))) {
+            return false;
+        }
+    }
+
+    uint64_t oldest = SNAPSHOT_IDLE; // Only scanned for the registry if some chain needs reclaiming
+    for (size_t i = 0; i < lock_set->size; i++) {
+        if (version_chains_over_bound(&region->versions, lock_set->stripes[i])) {
+            if (oldest == SNAPSHOT_IDLE) {
+                oldest = snapshot_registry_oldest(region->snapshots, &region->lock.clock);
+            }
+            version_chains_reclaim(&region->versions, lock_set->stripes[i], oldest);
+        }
+    }
+    return true;
+}
+
+/** Read a range of words at once: sample the stripes it covers, copy it, then validate them.
+ * @param region        Shared memory region
+ * @param transaction   Transaction reading the range (neither a snapshot reader nor irrevocable)
+ * @param source        Start address of the range (in the shared region)
+ * @param size          Size of the range (in bytes), a multiple of the alignment
+ * @param target        Address receiving the range (in a private region)
+ * @return Whether the range was read, the words having to be read one by one otherwise
+**/
+bool read_range(struct region* region, struct transaction* transaction, const void* source, size_t size, void* target) {
+    if (!transaction->is_ro && region->config.engine != ENGINE_ENCOUNTER_TIME
+            && write_set_overlaps(&transaction->write_set, source, size, region->align)) { // Some words must come from the write set
+        return false;
+    }
+
+    size_t words = size / region->align;
+    int first = find_lock(&region->lock, source);
+    int last = find_lock(&region->lock, source + size - region->align); // Stripes may cover several words
+    size_t count = words <= region->lock.mask ? (((uintptr_t) last - (uintptr_t) first) & region->lock.mask) + 1 : region->lock.mask + 1;
+    uint64_t newest;
+    if (!shared_lock_versioned_spinlock_sample_range(&region->lock, first, count, &newest)) { // Let the word path wait or abort
+        return false;
+    }
+    if (newest > transaction->rv) {
+        shared_lock_global_clock_advance(&region->lock, newest);
+        if (!extend_snapshot(&region->lock, transaction)) {
+            return false;
+        }
+        // A commit that locked a stripe between the sample and the extension may have a write version at most the new
+        // rv, so sample again: only the commits locking a stripe after rv was taken are then left, all above rv
+        if (!shared_lock_versioned_spinlock_sample_range(&region->lock, first, count, &newest) || newest > transaction->rv) {
+            return false; // Committed again in between, so let the word path read them one by one
+        }
+    }
+    uint64_t rv = transaction->rv; // Taken before the last sample
+
+    memcpy(target, source, size);
+
+    // Any commit locking one of the stripes after the last sample gets a write version above rv, so comparing
+    // with rv (rather than with every sampled version) is enough to detect a torn copy.
+    if (shared_lock_versioned_spinlock_validate_range(&region->lock, first, count, rv) != count) {
+        return false;
+    }
+    return read_set_add_range(&transaction->read_set, first, (int) count, source, size);
+}
+
+/** Read a word as it was at a snapshot, waiting for any commit installing new values to finish (multi-version engine).
+ * @param region        Shared memory region
+ * @param snapshot      Snapshot (read version) of the read-only transaction
+ * @param source_word   Address of the word (in the shared region)
+ * @param target_word   Address receiving the word (in a private region)
+ * @param align         Size of a word (in bytes), a constant in every specialized copy
+**/
+static force_inline void read_snapshot_word(struct region* region, uint64_t snapshot, const void* source_word, void* target_word, size_t align) {
+    int stripe = find_lock(&region->lock, source_word);
+    while (true) {
+        uint64_t version = shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe);
+        if (version & VERSIONED_SPINLOCK_LOCKED) {
+            _mm_pause();
+            continue;
+        }
+
+        if (version > snapshot) { // Overwritten since the snapshot, unless a neighbour word of the stripe was
+            const struct old_version* old_version = version_chains_find(&region->versions, stripe, source_word, snapshot);
+            if (old_version != NULL) {
+                memcpy(target_word, old_version->value, align);
+                return;
+            }
+        }
+
+        memcpy(target_word, source_word, align);
+        if (shared_lock_versioned_spinlock_validate_stripe(&region->lock, stripe, version)) { // No commit in between
+            return;
+        }
+    }
+}
+
+/** Store the written data to the shared memory region in address order, then release every locked stripe once with the write version.
+ * @param lock          Global lock object stored in region
+ * @param write_set     Write set holding the memory addresses and the values written to them, sorted by address (so no lookup may follow)
+ * @param lock_set      Distinct stripes of the write set
+ * @param size          Size of the memory region to be copied (equal to the alignment of the region)
+ * @param wv            Write version (according to TL2 algorithm)
+**/
+void store_write_set(struct shared_lock_t* lock, const struct write_set* write_set, const struct lock_set* lock_set, size_t size, uint64_t wv) {
+    write_set_write_back(write_set, size); // Runs of adjacent words at once
+    for (size_t i = 0; i < lock_set->size; i++) {
+        shared_lock_versioned_spinlock_release_stripe(lock, lock_set->stripes[i], wv);
+    }
+}
+
+/** Lock, validate and store the write set of a read-write transaction.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction to commit
+ * @return Whether the transaction committed, its stripes being unlocked otherwise
+**/
+bool commit_write_set(struct region* region, struct transaction* transaction) {
+    write_set_sort(&transaction->write_set); // Before locking, so that sorting does not lengthen the hold time (and the stripes come mostly in order)
+    if (unlikely(!lock_set_build(&transaction->lock_set, &region->lock, &transaction->write_set))) {
+        STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+        return false;
+    }
+
+    uint64_t floor;
+    size_t locked = lock_write_set(&region->lock, region->config.contention_policy, &transaction->lock_set,
+            transaction->read_set.size + transaction->write_set.size, &floor); // Attempt to lock the write set
+    if (locked < transaction->lock_set.size) {
+        STATS(transaction->abort_cause = TM_ABORT_WRITE_LOCKED);
+        PROFILE(profile_write_conflict(region, &transaction->write_set, transaction->lock_set.stripes[locked]));
+        return false;
+    }
+
+    uint64_t wv = shared_lock_global_clock_commit(&region->lock, floor); // Get the write version from the global clock
+
+    if (!transaction->is_irrevocable && (wv != transaction->rv + 1 || !global_clock_unique(&region->lock.clock))) { // If write version is 1 more than read version (and no other commit can share it), we do not need to perform any other validations
+        if (!validate_read_set(&region->lock, &transaction->read_set, &transaction->lock_set, transaction->rv)) { // Otherwise, we attempt to validate the read set
+            PROFILE(profile_validation(region, transaction)); // While its own stripes are still held
+            unlock_write_set(&region->lock, &transaction->lock_set, transaction->lock_set.size);
+            STATS(transaction->abort_cause = TM_ABORT_COMMIT_VALIDATION);
+            return false;
+        }
+    }
+    STATS(if (!transaction->is_irrevocable && wv == transaction->rv + 1 && global_clock_unique(&region->lock.clock)) stats_validation_skip(region->stats));
+
+    if (region->config.engine == ENGINE_MULTI_VERSION && unlikely(!save_old_versions(region, &transaction->write_set, &transaction->lock_set, wv))) {
+        unlock_write_set(&region->lock, &transaction->lock_set, transaction->lock_set.size);
+        STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+        return false;
+    }
+
+    PROFILE(profile_commit(region, transaction, wv));
+    store_write_set(&region->lock, &transaction->write_set, &transaction->lock_set, region->align, wv); // Commit changes
+    return true;
+}
+
+/** Announce a transaction about to lock stripes, waiting for the irrevocable transaction (if any) to end first.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction
+**/
+void announce_writer(struct region* region, struct transaction* transaction) {
+    if (region->irrevocability != NULL && !transaction->is_irrevocable && !transaction->is_announced) {
+        irrevocability_enter_commit(region->irrevocability);
+        transaction->is_announced = true;
+    }
+}
+
+/** Lock a stripe at write time (encounter-time locking), so that the words it covers can be written in place.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction
+ * @param stripe        Index of the stripe, not held by the transaction yet
+ * @param target_word   Word about to be written under the stripe, only sampled by profiled builds
+ * @return Whether the stripe was locked and the snapshot still holds
+**/
+bool lock_in_place(struct region* region, struct transaction* transaction, int stripe, const void* unused(target_word)) {
+    announce_writer(region, transaction);
+
+    uint64_t holder = VERSIONED_SPINLOCK_HOLDER(thread_id_get(), transaction->lock_set.size);
+    uint64_t version;
+    for (unsigned round = 0; !shared_lock_versioned_spinlock_try_acquire_stripe(&region->lock, stripe, holder, &version); round++) {
+        if (!contention_wait(region->config.contention_policy, VERSIONED_SPINLOCK_THREAD(version), round, transaction_work(transaction))) {
+            STATS(transaction->abort_cause = TM_ABORT_WRITE_LOCKED);
+            PROFILE(profiler_record(region->profiler, stripe, target_word, CONFLICT_HELD));
+            return false;
+        }
+    }
+    if (unlikely(!lock_set_add(&transaction->lock_set, stripe, version))) {
+        shared_lock_versioned_spinlock_release_stripe(&region->lock, stripe, version);
+        STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+        return false;
+    }
+
+    if (version > transaction->rv) { // Words of the stripe are now read in place, so the snapshot must cover its last commit
+        shared_lock_global_clock_advance(&region->lock, version);
+        if (!extend_snapshot(&region->lock, transaction)) {
+            STATS(transaction->abort_cause = TM_ABORT_READ_VALIDATION);
+            PROFILE(profile_validation(region, transaction));
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Write a word in place, locking its stripe first unless already held and saving its old value.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction (encounter-time locking engine)
+ * @param source_word   Address of the value to write (in a private region)
+ * @param target_word   Address of the word (in the shared region)
+ * @param align         Size of a word (in bytes), a constant in every specialized copy
+ * @return Whether the word was written
+**/
+static force_inline bool write_in_place(struct region* region, struct transaction* transaction, const void* source_word, void* target_word, size_t align) {
+    int stripe = find_lock(&region->lock, target_word);
+    uint64_t version;
+    if (!lock_set_owns(&transaction->lock_set, shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe), stripe, &version)
+            && !lock_in_place(region, transaction, stripe, target_word)) {
+        return false;
+    }
+
+    if (unlikely(!undo_log_add(&transaction->undo_log, target_word, align))) {
+        STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+        return false;
+    }
+    memcpy(target_word, source_word, align);
+    return true;
+}
+
+/** Get a new write version for the stripes held by a transaction, above the versions they had when locked.
+ * @param region        Shared memory region
+ * @param transaction   Transaction holding stripes (encounter-time locking engine)
+ * @return Write version to release the stripes with
+**/
+uint64_t write_version_in_place(struct region* region, const struct transaction* transaction) {
+    const struct lock_set* lock_set = &transaction->lock_set;
+    uint64_t floor = 0;
+    for (size_t i = 0; i < lock_set->size; i++) {
+        if (lock_set->versions[i] > floor) {
+            floor = lock_set->versions[i];
+        }
+    }
+    return shared_lock_global_clock_commit(&region->lock, floor);
+}
+
+/** Release the stripes held by a transaction with a write version.
+ * @param region        Shared memory region
+ * @param transaction   Transaction holding stripes (encounter-time locking engine)
+ * @param wv            Write version, from write_version_in_place
+**/
+void release_in_place(struct region* region, const struct transaction* transaction, uint64_t wv) {
+    const struct lock_set* lock_set = &transaction->lock_set;
+    for (size_t i = 0; i < lock_set->size; i++) {
+        shared_lock_versioned_spinlock_release_stripe(&region->lock, lock_set->stripes[i], wv);
+    }
+}
+
+/** Validate the reads of a read-write transaction whose words are already written in place, then release its stripes.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction to commit (encounter-time locking engine)
+ * @return Whether the transaction committed, its stripes being still held otherwise
+**/
+bool commit_in_place(struct region* region, struct transaction* transaction) {
+    if (transaction->lock_set.size == 0) { // Wrote nothing, and every read was consistent with rv when it was made
+        return true;
+    }
+
+    uint64_t wv = write_version_in_place(region, transaction);
+    bool skip = transaction->is_irrevocable || (wv == transaction->rv + 1 && global_clock_unique(&region->lock.clock)); // No commit since the snapshot, as with the write set
+    if (!skip && !validate_read_set(&region->lock, &transaction->read_set, &transaction->lock_set, transaction->rv)) {
+        STATS(transaction->abort_cause = TM_ABORT_COMMIT_VALIDATION);
+        PROFILE(profile_validation(region, transaction));
+        return false; // The abort releases the stripes with a version of its own
+    }
+    STATS(if (!transaction->is_irrevocable && skip) stats_validation_skip(region->stats));
+    // The words read their old values before their stripes were locked, so with a read version below wv
+    PROFILE(profile_commit(region, transaction, wv));
+    release_in_place(region, transaction, wv);
+    return true;
+}
+
+/** Get the segment allocator of a region, creating it at the first allocation.
+ * @param region Shared memory region
+ * @return Segment allocator of the region, NULL when running out of memory
+**/
+struct slab* get_slab(struct region* region) {
+    struct slab* slab = atomic_load_explicit(&region->slab, memory_order_acquire);
+    if (likely(slab != NULL)) {
+        return slab;
+    }
+
+    slab = (struct slab*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct slab));
+    if (unlikely(!slab)) {
+        return NULL;
+    }
+    slab_init(slab, region->align, region->arena, &region->config);
+
+    struct slab* expected = NULL;
+    if (!atomic_compare_exchange_strong(&region->slab, &expected, slab)) { // Another thread created it first
+        slab_cleanup(slab);
+        free(slab);
+        return expected;
+    }
+    return slab;
+}
+
+/** Get the limbo lists of a region, creating them at the first free.
+ * @param region Shared memory region
+ * @return Limbo lists of the region, NULL when running out of memory
+**/
+struct reclamation* get_reclamation(struct region* region) {
+    struct reclamation* reclamation = atomic_load_explicit(&region->reclamation, memory_order_acquire);
+    if (likely(reclamation != NULL)) {
+        return reclamation;
+    }
+
+    reclamation = (struct reclamation*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct reclamation));
+    if (unlikely(!reclamation)) {
+        return NULL;
+    }
+    reclamation_init(reclamation);
+
+    struct reclamation* expected = NULL;
+    if (!atomic_compare_exchange_strong(&region->reclamation, &expected, reclamation)) { // Another thread created them first
+        reclamation_cleanup(reclamation);
+        free(reclamation);
+        return expected;
+    }
+    return reclamation;
+}
+
+/** Retire the segments freed by a committed transaction until no running transaction can read them.
+ * @param region    Shared memory region
+ * @param freed     Segments freed by the transaction
+**/
+void retire_segments(struct region* region, const struct segment_array* freed) {
+    // Past the begin time of every transaction that may have read a pointer to the segments before the commit
+    uint64_t retired_at = shared_lock_global_clock_commit(&region->lock, 0);
+    shared_lock_global_clock_advance(&region->lock, retired_at); // Lazy clock schemes must reach it for the segments to be returned
+
+    struct slab* slab = atomic_load_explicit(&region->slab, memory_order_acquire); // Allocated the segments
+    struct reclamation* reclamation = atomic_load_explicit(&region->reclamation, memory_order_acquire); // Created by tm_free
+    for (size_t i = 0; i < freed->size; i++) {
+        reclamation_retire(reclamation, slab, region->snapshots, &region->lock.clock, slab_node(slab, freed->segments[i]), retired_at);
+    }
+}
+
+/** Give the segments allocated by an aborted transaction back to the allocator, no other transaction having seen them.
+ * @param region    Shared memory region
+ * @param allocated Segments allocated by the transaction
+**/
+void recycle_segments(struct region* region, const struct segment_array* allocated) {
+    struct slab* slab = atomic_load_explicit(&region->slab, memory_order_acquire); // Allocated the segments
+    for (size_t i = 0; i < allocated->size; i++) {
+        slab_recycle(slab, slab_node(slab, allocated->segments[i]));
+    }
+}
+
+/** Abort a transaction, recording the attempt in the abort history of the thread.
+ * @param region        Shared memory region
+ * @param transaction   Transaction to abort, whose abort cause is set when collecting statistics
+**/
+void abort_transaction(struct region* region, struct transaction* transaction) {
+    STATS(stats_abort(region->stats, transaction->is_ro, transaction->abort_cause));
+    bool rolled_back = region->config.engine == ENGINE_ENCOUNTER_TIME && transaction->lock_set.size > 0;
+    if (rolled_back) {
+        undo_log_rollback(&transaction->undo_log, region->align);
+        // Restoring the old versions would let a reader that copied a word written in place validate it
+        release_in_place(region, transaction, write_version_in_place(region, transaction));
+    }
+    if (transaction->alloc_log.allocated.size > 0) { // After the rollback, which may write to them
+        recycle_segments(region, &transaction->alloc_log.allocated);
+    }
+    if (transaction->snapshot_slot >= 0) {
+        snapshot_registry_leave(region->snapshots, transaction->snapshot_slot);
+    }
+    if (transaction->is_announced) {
+        irrevocability_leave_commit(region->irrevocability);
+    }
+    if (unlikely(transaction->is_irrevocable)) { // Only when running out of memory
+        irrevocability_release(region->irrevocability);
+    }
+    contention_abort(transaction_work(transaction), rolled_back); // The newer versions fail the reads of others, so the retry backs off
+    transaction_release(transaction);
+}
+
+/** Allocate the first segment of a region, in an arena holding the locks next to the words unless the layout is a lock table.
+ * @param region    Shared memory region, whose configuration is read
+ * @param size      Size of the first segment (in bytes)
+ * @param align     Alignment of the region (in bytes)
+ * @return Whether the first segment was allocated (zeroed)
+**/
+bool create_first_segment(struct region* region, size_t size, size_t align) {
+    region->arena = NULL;
+    region->start_mapping = 0;
+    if (region->config.lock_layout != LOCK_LAYOUT_TABLE) {
+        int grain_shift = __builtin_ctzl(align);
+        if (region->config.lock_layout == LOCK_LAYOUT_LINE && align < CACHE_LINE_SIZE) {
+            grain_shift = __builtin_ctzl(CACHE_LINE_SIZE);
+        }
+
+        struct arena* arena = (struct arena*) malloc(sizeof(struct arena));
+        if (likely(arena != NULL) && likely(arena_init(arena, size, grain_shift, align))) {
+            if (mapping_enabled(&region->config)) { // The reservation is too large for the huge page pool, so only advise it
+                mapping_advise(arena->mapping, arena->mapping_size, &region->config);
+            }
+            region->arena = arena;
+            region->start = arena_alloc(arena, size); // Fresh pages are already zeroed
+            return true;
+        }
+        free(arena);
+        region->config.lock_layout = LOCK_LAYOUT_TABLE; // The address range could not be reserved
+    }
+
+    if (mapping_enabled(&region->config)) { // Zeroed pages, placed by the kernel
+        region->start_mapping = size;
+        region->start = mapping_alloc(&region->start_mapping, align, &region->config);
+        return region->start != NULL;
+    }
+
+    if (unlikely(posix_memalign(&(region->start), align, size) != 0)) {
+        return false;
+    }
+    memset(region->start, 0, size);
+    return true;
+}
+
+/** Free the first segment of a region, with the arena holding it and every other segment (if any).
+ * @param region Shared memory region
+**/
+void free_first_segment(struct region* region) {
+    if (region->arena != NULL) {
+        arena_cleanup(region->arena);
+        free(region->arena);
+    }
+    else if (region->start_mapping > 0) {
+        mapping_free(region->start, region->start_mapping);
+    }
+    else {
+        free(region->start);
+    }
+}
+
+/** Read words of the shared memory region in a transaction, inlined into one copy per common word size.
+ * @param region        Shared memory region
+ * @param transaction   Transaction to use
+ * @param source        Source start address (in the shared region)
+ * @param size          Length to copy (in bytes), a positive multiple of the alignment
+ * @param target        Target start address (in a private region)
+ * @param align         Size of a word (in bytes), a constant in every specialized copy
+ * @return Whether the whole transaction can continue
+**/
+static force_inline bool read_words(struct region* region, struct transaction* transaction, const void* source, size_t size, void* target, size_t align) {
+    if (transaction->reads_snapshot) { // Read-only transactions reading a snapshot need neither validation nor a read set
+        for (size_t offset = 0; offset < size; offset += align) {
+            read_snapshot_word(region, transaction->rv, source + offset, target + offset, align);
+        }
+        return true;
+    }
+
+    if (unlikely(transaction->is_irrevocable)) { // Nothing commits concurrently, so reads need neither validation nor a read set
+        if (transaction->is_ro || !write_set_overlaps(&transaction->write_set, source, size, align)) {
+            memcpy(target, source, size);
+            return true;
+        }
+        for (size_t offset = 0; offset < size; offset += align) {
+            struct write_entry* old_entry = transaction->is_ro ? NULL : write_set_find(&transaction->write_set, source + offset);
+            memcpy(target + offset, old_entry != NULL ? old_entry->value : source + offset, align);
+        }
+        return true;
+    }
+
+    if (size > align && read_range(region, transaction, source, size, target)) { // Contiguous words: one copy, one validation
+        return true;
+    }
+
+    size_t num_bytes_read = 0;
+    const void* source_word = source;
+    void* target_word = target;
+    do
+    {
+        if (!transaction->is_ro && region->config.engine != ENGINE_ENCOUNTER_TIME) { // If it is a read-write transaction buffering its writes
+            struct write_entry* old_entry = write_set_find(&transaction->write_set, source_word);
+
+            if (old_entry != NULL) { // If the address we are trying to read is in the write set
+                memcpy(target_word, old_entry->value, align);
+                goto next_word;
+            }
+        }
+
+        int stripe = find_lock(&region->lock, source_word);
+        uint64_t version = shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe); // Sample the lock before reading the word
+
+        uint64_t owned_version;
+        if (unlikely(version & VERSIONED_SPINLOCK_LOCKED) && lock_set_owns(&transaction->lock_set, version, stripe, &owned_version)) { // Written in place by this transaction
+            memcpy(target_word, source_word, align);
+            goto next_word;
+        }
+
+        for (unsigned round = 0; unlikely(version & VERSIONED_SPINLOCK_LOCKED); round++) { // Wait for the owner to commit, as long as the contention policy allows
+            if (!contention_wait(region->config.contention_policy, VERSIONED_SPINLOCK_THREAD(version), round, transaction_work(transaction))) {
+                STATS(transaction->abort_cause = TM_ABORT_READ_LOCKED);
+                PROFILE(profiler_record(region->profiler, stripe, source_word, CONFLICT_HELD));
+                abort_transaction(region, transaction);
+                return false;
+            }
+            version = shared_lock_versioned_spinlock_sample_stripe(&region->lock, stripe);
+        }
+
+        if (version > transaction->rv) { // If the address was written after the transaction started
+            shared_lock_global_clock_advance(&region->lock, version); // Lazy clock schemes may not cover that version yet
+            if (!extend_snapshot(&region->lock, transaction)) { // Try to move the snapshot forward instead of aborting
+                STATS(transaction->abort_cause = TM_ABORT_READ_VALIDATION);
+                PROFILE(profile_validation(region, transaction));
+                abort_transaction(region, transaction);
+                return false;
+            }
+        }
+
+        memcpy(target_word, source_word, align);
+
+        if (!shared_lock_versioned_spinlock_validate_stripe(&region->lock, stripe, version)) { // Attempt to validate the address we read (i.e. the lock did not change)
+            STATS(transaction->abort_cause = TM_ABORT_READ_VALIDATION);
+            PROFILE(profile_conflict(region, transaction, stripe, source_word, version));
+            abort_transaction(region, transaction);
+            return false;
+        }
+
+        if (unlikely(!read_set_add(&transaction->read_set, stripe, source_word))) { // Kept by read-only transactions too, for snapshot extension
+            STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+            abort_transaction(region, transaction);
+            return false;
+        }
+
+    next_word:
+        source_word += align;
+        target_word += align;
+        num_bytes_read += align;
+    } while (num_bytes_read < size); // Check if we have read the requested number of bytes
+
+    return true;
+}
+
+/** Write words of the shared memory region in a transaction, inlined into one copy per common word size.
+ * @param region        Shared memory region
+ * @param transaction   Transaction to use
+ * @param source        Source start address (in a private region)
+ * @param size          Length to copy (in bytes), a positive multiple of the alignment
+ * @param target        Target start address (in the shared region)
+ * @param align         Size of a word (in bytes), a constant in every specialized copy
+ * @return Whether the whole transaction can continue
+**/
+static force_inline bool write_words(struct region* region, struct transaction* transaction, const void* source, size_t size, void* target, size_t align) {
+    if (region->config.engine == ENGINE_ENCOUNTER_TIME) { // Lock every stripe at its first write, then write in place
+        for (size_t offset = 0; offset < size; offset += align) {
+            if (!write_in_place(region, transaction, source + offset, target + offset, align)) {
+                abort_transaction(region, transaction);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool fresh = size > align && !write_set_overlaps(&transaction->write_set, target, size, align); // No word of the range needs a lookup
+
+    size_t num_bytes_read = 0;
+    const void* source_word = source;
+    void* target_word = target;
+
+    do
+    {
+        struct write_entry* old_entry = fresh ? NULL : write_set_find(&transaction->write_set, target_word);
+
+        if (old_entry == NULL) { // If the address we are trying to write is not in the write set
+            if (unlikely(!write_set_add(&transaction->write_set, target_word, source_word, align))) {
+                STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+                abort_transaction(region, transaction);
+                return false;
+            }
+        }
+        else { // If the address we are trying to write is in the write set
+            write_entry_overwrite(old_entry, source_word, align);
+        }
+
+        source_word += align;
+        target_word += align;
+        num_bytes_read += align;
+    } while (num_bytes_read < size); // Check if we have written the requested number of bytes
+
+    return true;
+}
+
+/** Define the read and write paths of one word size, and the table of them.
+ * @param name  Suffix of the generated functions and table
+ * @param align Size of a word (in bytes), a constant except for the generic table
+**/
+#define WORD_OPS(name, align) \
+    static bool read_words_##name(struct region* region, struct transaction* transaction, const void* source, size_t size, void* target) { \
+        return read_words(region, transaction, source, size, target, (align)); \
+    } \
+    static bool write_words_##name(struct region* region, struct transaction* transaction, const void* source, size_t size, void* target) { \
+        return write_words(region, transaction, source, size, target, (align)); \
+    } \
+    static const struct word_ops word_ops_##name = { read_words_##name, write_words_##name };
+
+WORD_OPS(1, 1)
+WORD_OPS(2, 2)
+WORD_OPS(4, 4)
+WORD_OPS(8, 8)
+WORD_OPS(16, 16)
+WORD_OPS(any, region->align) // Larger words, copied with a call to memcpy
+
+#undef WORD_OPS
+
+static const struct word_ops* const word_ops_table[] = { &word_ops_1, &word_ops_2, &word_ops_4, &word_ops_8, &word_ops_16 }; // Indexed by log2 of the word size
+
+/** Pick the read and write paths specialized for a word size.
+ * @param align Size of a word (in bytes), a power of 2
+ * @return Paths of that word size, the generic ones for words larger than 16 bytes
+**/
+const struct word_ops* select_word_ops(size_t align) {
+    if (align <= 16) {
+        return word_ops_table[__builtin_ctzl(align)];
+    }
+    return &word_ops_any;
 }
 
 // End of helper functions used to implement TL2
@@ -139,16 +953,75 @@ shared_t tm_create(size_t size, size_t align) {
         return invalid_shared;
     }
 
-    if (unlikely(posix_memalign(&(region->start), align, size) != 0)) {
+    config_init(&(region->config));
+    if (unlikely(!create_first_segment(region, size, align))) {
         free(region);
         return invalid_shared;
     }
 
-    shared_lock_init(&(region->lock));
-    memset(region->start, 0, size);
-    region->allocs      = NULL;
+    if (unlikely(!shared_lock_init(&(region->lock), &(region->config), size, align, region->arena))) {
+        free_first_segment(region);
+        free(region);
+        return invalid_shared;
+    }
+
+    region->irrevocability = NULL;
+    if (region->config.irrevocable_after > 0) {
+        region->irrevocability = (struct irrevocability*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct irrevocability));
+        if (unlikely(!region->irrevocability)) {
+            shared_lock_cleanup(&(region->lock));
+            free_first_segment(region);
+            free(region);
+            return invalid_shared;
+        }
+        irrevocability_init(region->irrevocability);
+    }
+
+    region->snapshots = NULL;
+    if (region->config.engine == ENGINE_MULTI_VERSION || region->config.reclaim) {
+        region->snapshots = (struct snapshot_registry*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct snapshot_registry));
+        if (unlikely(!region->snapshots || (region->config.engine == ENGINE_MULTI_VERSION
+                && !version_chains_init(&(region->versions), region->lock.mask + 1, align)))) {
+            free(region->snapshots);
+            free(region->irrevocability);
+            shared_lock_cleanup(&(region->lock));
+            free_first_segment(region);
+            free(region);
+            return invalid_shared;
+        }
+        snapshot_registry_init(region->snapshots);
+    }
+    atomic_init(&region->slab, NULL);
+    atomic_init(&region->reclamation, NULL);
+
     region->size        = size;
     region->align       = align;
+    region->ops         = select_word_ops(align);
+
+#ifdef TM_PROFILE
+    region->profiler = NULL; // Not allocated yet if tm_destroy cleans up after a failure below
+#endif
+#ifdef TM_STATS
+    region->stats = (struct stats*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct stats));
+    if (unlikely(!region->stats)) {
+        tm_destroy(region);
+        return invalid_shared;
+    }
+    stats_init(region->stats);
+#endif
+#ifdef TM_PROFILE
+    region->profiler = (struct profiler*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct profiler));
+    if (unlikely(!region->profiler)) {
+        tm_destroy(region);
+        return invalid_shared;
+    }
+    if (unlikely(!profiler_init(region->profiler, (unsigned) region->config.profile_period, region->config.profile_top, align, size / align))) {
+        free(region->profiler);
+        region->profiler = NULL;
+        tm_destroy(region);
+        return invalid_shared;
+    }
+#endif
     return region;
 }
 
@@ -158,14 +1031,44 @@ shared_t tm_create(size_t size, size_t align) {
 void tm_destroy(shared_t shared) {
     struct region* region = (struct region*) shared;
 
-    while (region->allocs) { // Free allocated segments
-        segment_list tail = region->allocs->next;
-        free(region->allocs);
-        region->allocs = tail;
+#ifdef TM_STATS
+    if (region->stats != NULL) { // NULL if tm_create failed to allocate it
+        if (region->config.stats_dump) {
+            struct tm_stats total;
+            stats_collect(region->stats, &total);
+            stats_dump(&total, stderr);
+        }
+        free(region->stats);
+    }
+#endif
+#ifdef TM_PROFILE
+    if (region->profiler != NULL) { // NULL if tm_create failed to allocate it
+        profiler_report(region->profiler, stderr);
+        profiler_cleanup(region->profiler);
+        free(region->profiler);
+    }
+#endif
+
+    struct slab* slab = atomic_load(&region->slab);
+    if (slab != NULL) { // Free allocated segments, retired ones included
+        slab_cleanup(slab);
+        free(slab);
+    }
+
+    struct reclamation* reclamation = atomic_load(&region->reclamation);
+    if (reclamation != NULL) {
+        reclamation_cleanup(reclamation);
+        free(reclamation);
     }
 
+    if (region->config.engine == ENGINE_MULTI_VERSION) {
+        version_chains_cleanup(&region->versions, region->lock.mask + 1);
+    }
+    free(region->snapshots);
+
+    free(region->irrevocability);
     shared_lock_cleanup(&region->lock);
-    free(region->start);
+    free_first_segment(region);
     free(region);
 }
 
@@ -193,6 +1096,20 @@ size_t tm_align(shared_t shared) {
     return ((struct region*) shared)->align;
 }
 
+/** [thread-safe] Sum up the statistics of the transactions run on the given shared memory region so far.
+ * @param shared Shared memory region to query
+ * @param stats  Receives the statistics
+ * @return Whether statistics are collected (the library being built with -DTM_STATS)
+**/
+bool tm_stats(shared_t unused(shared), struct tm_stats* unused(stats)) {
+#ifdef TM_STATS
+    stats_collect(((struct region*) shared)->stats, stats);
+    return true;
+#else
+    return false;
+#endif
+}
+
 /** [thread-safe] Begin a new transaction on the given shared memory region.
  * @param shared Shared memory region to start a transaction on
  * @param is_ro  Whether the transaction is read-only
@@ -201,14 +1118,33 @@ size_t tm_align(shared_t shared) {
 tx_t tm_begin(shared_t shared, bool is_ro) {
     struct region* region = (struct region*) shared;
 
-    struct transaction* transaction = (struct transaction*) malloc(sizeof(struct transaction));
+    struct transaction* transaction = transaction_acquire(); // Reuse one of the descriptors of this thread
 
     if (unlikely(!transaction)) {
         return invalid_tx;
     }
 
     transaction_init(transaction, is_ro);
-    transaction->rv = shared_lock_global_clock_get(&region->lock); // Sample the global clock and store it as read version
+    if (region->irrevocability != NULL && unlikely(contention_aborts() >= (unsigned) region->config.irrevocable_after)) { // Stop retrying optimistically
+        irrevocability_acquire(region->irrevocability);
+        transaction->is_irrevocable = true;
+    }
+    else {
+        contention_begin(region->config.contention_policy); // Back off first if the previous attempt aborted
+    }
+
+    if (region->snapshots != NULL) { // Announce the begin time, so that writers keep the old versions and the freed segments it may read
+        transaction->snapshot_slot = snapshot_registry_enter(region->snapshots, &region->lock.clock, &transaction->rv);
+        transaction->reads_snapshot = is_ro && region->config.engine == ENGINE_MULTI_VERSION && !transaction->is_irrevocable
+                && likely(transaction->snapshot_slot != SNAPSHOT_REGISTRY_OVERFLOW);
+    }
+    else {
+        transaction->rv = shared_lock_global_clock_get(&region->lock); // Sample the global clock and store it as read version
+    }
+
+    if (unlikely(transaction->is_irrevocable)) {
+        transaction->rv = VERSIONED_SPINLOCK_LOCKED - 1; // Nothing commits until the transaction ends, so any version can be read
+    }
     return (tx_t)transaction; // Return a pointer to the transaction
 }
 
@@ -218,33 +1154,43 @@ tx_t tm_begin(shared_t shared, bool is_ro) {
  * @return Whether the whole transaction committed
 **/
 bool tm_end(shared_t shared, tx_t tx) {
+    struct region* region = (struct region*) shared;
     struct transaction* transaction = (struct transaction*) tx;
 
     if (!transaction->is_ro) { // if it is a read-write transaction
-        struct region* region = (struct region*) shared;
+        bool committed;
+        if (region->config.engine == ENGINE_ENCOUNTER_TIME) {
+            committed = commit_in_place(region, transaction);
+        }
+        else {
+            announce_writer(region, transaction); // Wait for the irrevocable transaction to end, if any
+            committed = commit_write_set(region, transaction);
+        }
 
-        if (!lock_write_set(&region->lock, transaction->first_write_node)) { // Attempt to lock the write set
-            transaction_cleanup(transaction);
-            free(transaction);
+        if (!committed) {
+            abort_transaction(region, transaction);
             return false;
         }
 
-        int wv = shared_lock_global_clock_increment_and_get(&region->lock); // Sample the global clock and store it as write version
-
-        if (wv != transaction->rv + 1) { // If write version is 1 more than read version, we do not need to perform any other validations
-            if (!validate_read_set(&region->lock, transaction->first_read_node, transaction->rv)) { // Otherwise, we attempt to validate the read set
-                unlock_write_set(&region->lock, transaction->first_write_node, NULL);
-                transaction_cleanup(transaction);
-                free(transaction);
-                return false;
-            }
+        if (transaction->alloc_log.freed.size > 0) {
+            retire_segments(region, &transaction->alloc_log.freed);
         }
-        
-        store_write_set(&region->lock, transaction->first_write_node, region->align, wv); // Commit changes
-        transaction_cleanup(transaction);
     }
 
-    free(transaction);
+    if (transaction->snapshot_slot >= 0) { // Stop protecting the old versions and the freed segments it may have read
+        snapshot_registry_leave(region->snapshots, transaction->snapshot_slot);
+    }
+
+    if (transaction->is_announced) {
+        irrevocability_leave_commit(region->irrevocability);
+    }
+    if (unlikely(transaction->is_irrevocable)) {
+        irrevocability_release(region->irrevocability);
+    }
+    STATS(stats_commit(region->stats, transaction->is_ro, transaction->read_set.size + transaction->read_set.num_ranges,
+            transaction->write_set.size + transaction->undo_log.size)); // Either one is empty, depending on the engine
+    contention_commit();
+    transaction_release(transaction);
     return true;
 }
 
@@ -258,44 +1204,7 @@ bool tm_end(shared_t shared, tx_t tx) {
 **/
 bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* target) {
     struct region* region = (struct region*) shared;
-    struct transaction* transaction = (struct transaction*) tx;
-
-    size_t num_bytes_read = 0;
-    const void* source_word = source;
-    void* target_word = target;
-    do
-    {
-        if (transaction->is_ro) { // If it is a read-only transaction
-            memcpy(target_word, source_word, region->align);
-        }
-        else { // If it is a read-write transaction
-            struct write_node* old_node = write_node_find(transaction->first_write_node, source_word);
-
-            if (old_node == NULL) { // If the address we are trying to read is not in the write set
-                if (unlikely(!read_set_add(&transaction->first_read_node, &transaction->last_read_node, source_word))) {
-                    transaction_cleanup(transaction);
-                    free(transaction);
-                    return false;
-                }
-                memcpy(target_word, source_word, region->align);
-            }
-            else { // If the address we are trying to read is in the write set
-                memcpy(target_word, old_node->value, region->align);
-            }
-        }
-
-        if (!shared_lock_versioned_spinlock_validate(&region->lock, source_word, transaction->rv)) { // Attempt to validate the address we read
-            transaction_cleanup(transaction);
-            free(transaction);
-            return false;
-        }
-
-        source_word += region->align;
-        target_word += region->align;
-        num_bytes_read += region->align;
-    } while (num_bytes_read < size); // Check if we have read the requested number of bytes
-
-    return true;
+    return region->ops->read(region, (struct transaction*) tx, source, size, target); // Specialized for the word size of the region
 }
 
 /** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region.
@@ -308,33 +1217,7 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
 **/
 bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* target) {
     struct region* region = (struct region*) shared;
-    struct transaction* transaction = (struct transaction*) tx;
-
-    size_t num_bytes_read = 0;
-    const void* source_word = source;
-    void* target_word = target;
-
-    do
-    {
-        struct write_node* old_node = write_node_find(transaction->first_write_node, target_word);
-
-        if (old_node == NULL) { // If the address we are trying to write is not in the write set
-            if (unlikely(!write_set_add(&transaction->first_write_node, &transaction->last_write_node, target_word, source_word, region->align))) {
-                transaction_cleanup(transaction);
-                free(transaction);
-                return false;
-            }
-        }
-        else { // If the address we are trying to write is in the write set
-            write_node_overwrite(old_node, source_word, region->align);
-        }
-
-        source_word += region->align;
-        target_word += region->align;
-        num_bytes_read += region->align;
-    } while (num_bytes_read < size); // Check if we have written the requested number of bytes
-    
-    return true;
+    return region->ops->write(region, (struct transaction*) tx, source, size, target); // Specialized for the word size of the region
 }
 
 /** [thread-safe] Memory allocation in the given transaction.
@@ -344,28 +1227,21 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
  * @param target Pointer in private memory receiving the address of the first byte of the newly allocated, aligned segment
  * @return Whether the whole transaction can continue (success/nomem), or not (abort_alloc)
 **/
-alloc_t tm_alloc(shared_t shared, tx_t unused(tx), size_t size, void** target) {
+alloc_t tm_alloc(shared_t shared, tx_t tx, size_t size, void** target) {
     struct region* region = (struct region*) shared;
+    struct transaction* transaction = (struct transaction*) tx;
 
-    size_t align = region->align;
-    align = align < sizeof(struct segment_node*) ? sizeof(void*) : align;
-
-    struct segment_node* sn;
-    if (unlikely(posix_memalign((void**)&sn, align, sizeof(struct segment_node) + size) != 0)) {
+    struct slab* slab = get_slab(region);
+    void* segment = slab != NULL ? slab_alloc(slab, size) : NULL; // From the free lists of this thread, without any shared lock
+    if (unlikely(!segment)) {
+        return nomem_alloc;
+    }
+    if (unlikely(!alloc_log_add_alloc(&transaction->alloc_log, segment))) { // Recycled if the transaction aborts
+        slab_recycle(slab, slab_node(slab, segment));
         return nomem_alloc;
     }
-    sn->prev = NULL;
-
-    shared_lock_segment_lock_acquire(&region->lock); // Only one transaction is allowed to add allocated segments to the region at a time
-    sn->next = region->allocs;
-    if (sn->next) sn->next->prev = sn;
-    region->allocs = sn;
-    shared_lock_segment_lock_release(&region->lock);
 
-    void* segment = (void*) ((uintptr_t) sn + sizeof(struct segment_node));
-    memset(segment, 0, size);
     *target = segment;
-
     return success_alloc;
 }
 
@@ -375,6 +1251,18 @@ alloc_t tm_alloc(shared_t shared, tx_t unused(tx), size_t size, void** target) {
  * @param target Address of the first byte of the previously allocated segment to deallocate
  * @return Whether the whole transaction can continue
 **/
-bool tm_free(shared_t unused(shared), tx_t unused(tx), void* unused(segment)) {
-    return true; // No need to free anything here. All the allocated segments will be freed upon tm_destroy call
+bool tm_free(shared_t shared, tx_t tx, void* segment) {
+    struct region* region = (struct region*) shared;
+    struct transaction* transaction = (struct transaction*) tx;
+
+    if (!region->config.reclaim) {
+        return true; // All the allocated segments will be freed upon tm_destroy call
+    }
+
+    if (unlikely(!get_reclamation(region) || !alloc_log_add_free(&transaction->alloc_log, segment))) { // Retired at commit, so an abort keeps the segment
+        STATS(transaction->abort_cause = TM_ABORT_NO_MEMORY);
+        abort_transaction(region, transaction);
+        return false;
+    }
+    return true;
 }
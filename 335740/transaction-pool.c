@@ -0,0 +1,47 @@
+#include "transaction-pool.h"
+
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local struct pool_link* pool = NULL; // Descriptors of this thread that are not in use
+
+static void pool_key_create(void) {
+    pthread_key_create(&pool_key, transaction_pool_destroy);
+}
+
+/** Get a descriptor of the calling thread, allocating one only when all of them are in use.
+ * @param kind Kind of descriptor
+ * @return Descriptor, NULL on allocation failure
+**/
+struct pool_link* transaction_pool_acquire(const struct pool_kind* kind) {
+    struct pool_link* link = pool;
+    if (likely(link != NULL)) { // Steady state: reuse a descriptor of this thread
+        pool = link->next_free;
+        return link;
+    }
+
+    pthread_once(&pool_key_once, pool_key_create);
+    link = (struct pool_link*) aligned_alloc(CACHE_LINE_SIZE, kind->size);
+    if (unlikely(!link)) {
+        return NULL;
+    }
+    kind->create(link);
+    pthread_setspecific(pool_key, (void*) kind); // Non-NULL so that the destructor runs on thread exit, and frees this kind
+    return link;
+}
+
+/** Give a descriptor back to the pool of the calling thread.
+ * @param link Descriptor, already cleaned up
+**/
+void transaction_pool_release(struct pool_link* link) {
+    link->next_free = pool;
+    pool = link;
+}
+
+void transaction_pool_destroy(void* kind) {
+    while (pool != NULL) {
+        struct pool_link* next = pool->next_free;
+        ((const struct pool_kind*) kind)->destroy(pool);
+        free(pool);
+        pool = next;
+    }
+}
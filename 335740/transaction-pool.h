@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "macros.h"
+
+/**
+ * @brief Link of a descriptor in the pool of its thread, the first member of every pooled descriptor.
+ */
+struct pool_link {
+    struct pool_link* next_free; // Next descriptor in the thread's pool
+};
+
+/**
+ * @brief Kind of descriptor handed out by the pool: its size, and how to set up and free its logs.
+ * Each library pools a single kind, the transaction descriptor it defines.
+ */
+struct pool_kind {
+    size_t size;                             // Size of a descriptor (in bytes, a multiple of CACHE_LINE_SIZE)
+    void (*create)(struct pool_link* link);  // Initialize the logs of a newly allocated descriptor
+    void (*destroy)(struct pool_link* link); // Free the logs of a descriptor, when its thread exits
+};
+
+struct pool_link* transaction_pool_acquire(const struct pool_kind* kind);
+
+void transaction_pool_release(struct pool_link* link);
+
+void transaction_pool_destroy(void* kind); // private fn
@@ -1,12 +1,50 @@
 #include "transaction.h"
 
+static const struct pool_kind transaction_kind = {
+    .size = sizeof(struct transaction),
+    .create = transaction_create,
+    .destroy = transaction_destroy,
+};
+
+struct transaction* transaction_acquire(void) {
+    return (struct transaction*) transaction_pool_acquire(&transaction_kind);
+}
+
+void transaction_release(struct transaction* transaction) {
+    transaction_cleanup(transaction);
+    transaction_pool_release(&transaction->link);
+}
+
+void transaction_create(struct pool_link* link) {
+    struct transaction* transaction = (struct transaction*) link;
+    read_set_init(&transaction->read_set);
+    write_set_init(&transaction->write_set);
+    lock_set_init(&transaction->lock_set);
+    undo_log_init(&transaction->undo_log);
+    alloc_log_init(&transaction->alloc_log);
+}
+
 void transaction_init(struct transaction* transaction, bool is_ro) {
     transaction->is_ro = is_ro;
-    read_set_init(&transaction->first_read_node, &transaction->last_read_node);
-    write_set_init(&transaction->first_write_node, &transaction->last_write_node);
+    transaction->is_irrevocable = false;
+    transaction->is_announced = false;
+    transaction->reads_snapshot = false;
+    transaction->snapshot_slot = -1;
 }
 
 void transaction_cleanup(struct transaction* transaction) {
-    read_set_cleanup(transaction->first_read_node);
-    write_set_cleanup(transaction->first_write_node);
+    read_set_cleanup(&transaction->read_set);
+    write_set_cleanup(&transaction->write_set);
+    lock_set_cleanup(&transaction->lock_set);
+    undo_log_cleanup(&transaction->undo_log);
+    alloc_log_cleanup(&transaction->alloc_log);
+}
+
+void transaction_destroy(struct pool_link* link) {
+    struct transaction* transaction = (struct transaction*) link;
+    read_set_destroy(&transaction->read_set);
+    write_set_destroy(&transaction->write_set);
+    lock_set_destroy(&transaction->lock_set);
+    undo_log_destroy(&transaction->undo_log);
+    alloc_log_destroy(&transaction->alloc_log);
 }
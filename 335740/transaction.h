@@ -1,25 +1,59 @@
 #pragma once
 
 #include <stdbool.h>
-
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <tm-stats.h>
+#include "macros.h"
+#include "alloc-log.h"
+#include "lock-set.h"
 #include "read-set.h"
+#include "transaction-pool.h"
+#include "undo-log.h"
 #include "write-set.h"
 
 /**
  * @brief Holds all the reads/writes performed by a transaction.
  */
 struct transaction {
+    struct pool_link link; // Link in the thread's pool of descriptors (first member)
     bool is_ro;
-    int rv;
-    struct read_node* first_read_node;
-    struct read_node* last_read_node;
-    struct write_node* first_write_node;
-    struct write_node* last_write_node;
-};
+    bool is_irrevocable; // Holds the irrevocability token, so it cannot abort and reads without validation
+    bool is_announced; // Announced to the irrevocability token as writing, so that no irrevocable transaction runs meanwhile
+    uint64_t rv;
+    bool reads_snapshot; // Reads the versions of its snapshot (multi-version read-only transactions that got a slot)
+    int snapshot_slot; // Slot announcing the begin time to writers and to reclamation (-1 if the region keeps no registry)
+    struct read_set read_set;
+    struct write_set write_set;
+    struct lock_set lock_set; // Stripes locked at commit time (or at write time, encounter-time locking engine)
+    struct undo_log undo_log; // Old values of the words written in place (encounter-time locking engine only)
+    struct alloc_log alloc_log; // Segments to recycle if the transaction aborts, and to retire if it commits
+#ifdef TM_STATS
+    enum tm_abort_cause abort_cause; // Reason of the failure about to abort the transaction
+#endif
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct transaction* transaction_acquire(void);
+
+void transaction_release(struct transaction* transaction);
 
 void transaction_init(struct transaction* transaction, bool is_ro);
 
 void transaction_cleanup(struct transaction* transaction);
 
+/** Get the work done by a transaction so far, weighing in its priority under contention.
+ * @param transaction Transaction
+ * @return Number of accesses recorded by the transaction
+**/
+static inline size_t transaction_work(const struct transaction* transaction) {
+    return transaction->read_set.size + transaction->write_set.size + transaction->undo_log.size;
+}
+
+void transaction_create(struct pool_link* link); // private fn
+
+void transaction_destroy(struct pool_link* link); // private fn
+
 
 
@@ -0,0 +1,44 @@
+#include "undo-log.h"
+
+void undo_log_init(struct undo_log* log) {
+    log->log = NULL;
+    log->stride = 0;
+    log->size = 0;
+    log->capacity = 0;
+}
+
+bool undo_log_grow(struct undo_log* log) {
+    size_t capacity = log->capacity == 0 ? UNDO_LOG_INITIAL_CAPACITY : 2 * log->capacity;
+    while (capacity < (log->size + 1) * log->stride) {
+        capacity *= 2;
+    }
+
+    unsigned char* entries = (unsigned char*) realloc(log->log, capacity);
+    if (unlikely(!entries)) {
+        return false;
+    }
+
+    log->log = entries;
+    log->capacity = capacity;
+    return true;
+}
+
+/** Restore the saved values, newest first, so that a word written several times gets its oldest value back.
+ * @param log   Undo log
+ * @param size  Size of a word (in bytes)
+**/
+void undo_log_rollback(const struct undo_log* log, size_t size) {
+    for (size_t i = log->size; i > 0; i--) {
+        struct write_entry* entry = undo_log_entry(log, i - 1);
+        word_copy(entry->address, entry->value, size);
+    }
+}
+
+void undo_log_cleanup(struct undo_log* log) {
+    log->size = 0; // Reset the log, keeping its allocation for the next transaction
+}
+
+void undo_log_destroy(struct undo_log* log) {
+    free(log->log);
+    undo_log_init(log);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "word.h"
+#include "write-set.h"
+
+#define UNDO_LOG_INITIAL_CAPACITY 4096 // Initial size of the undo log (in bytes)
+
+/**
+ * @brief Flat undo log in write order: address of a word written in place followed by the value it had before.
+ * Entries share the layout of the redo log, but are never looked up, so there is neither filter nor index.
+ */
+struct undo_log {
+    unsigned char* log; // Entries of 'stride' bytes each (kept across transactions)
+    size_t stride;      // Size of one entry (in bytes)
+    size_t size;        // Number of entries in the log
+    size_t capacity;    // Size of the log allocation (in bytes)
+};
+
+void undo_log_init(struct undo_log* log);
+
+bool undo_log_grow(struct undo_log* log); // private fn
+
+/** Get an entry of the undo log.
+ * @param log      Undo log
+ * @param position Position of the entry in write order
+ * @return Entry at that position
+**/
+static inline struct write_entry* undo_log_entry(const struct undo_log* log, size_t position) {
+    return (struct write_entry*) (log->log + position * log->stride);
+}
+
+/** Save the value of a word about to be written in place.
+ * @param log   Undo log
+ * @param word  Address of the word (in the shared region)
+ * @param size  Size of a word (in bytes)
+ * @return Whether the value could be saved
+**/
+static force_inline bool undo_log_add(struct undo_log* log, void* word, size_t size) {
+    if (log->size == 0) { // The word size is fixed for the whole transaction, keep entries pointer-aligned
+        log->stride = (sizeof(struct write_entry) + size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    }
+    if (unlikely((log->size + 1) * log->stride > log->capacity)) {
+        if (unlikely(!undo_log_grow(log))) {
+            return false;
+        }
+    }
+
+    struct write_entry* entry = undo_log_entry(log, log->size++);
+    entry->address = word;
+    word_copy(entry->value, word, size);
+    return true;
+}
+
+void undo_log_rollback(const struct undo_log* log, size_t size);
+
+void undo_log_cleanup(struct undo_log* log);
+
+void undo_log_destroy(struct undo_log* log);
@@ -0,0 +1,92 @@
+#include "version-chain.h"
+
+bool version_chains_init(struct version_chains* chains, size_t num_stripes, size_t size) {
+    chains->heads = (struct old_version* _Atomic*) calloc(num_stripes, sizeof(struct old_version*));
+    chains->lengths = (size_t*) calloc(num_stripes, sizeof(size_t));
+    if (unlikely(!chains->heads || !chains->lengths)) {
+        free(chains->heads);
+        free(chains->lengths);
+        return false;
+    }
+    chains->size = size;
+    return true;
+}
+
+/** Save the current value of a word before a commit overwrites it. The caller holds the stripe's lock.
+ * @param chains    Version chains
+ * @param stripe    Lock stripe of the word
+ * @param address   Address of the word
+ * @param until     Write version of the commit
+ * @return Whether the version could be saved
+**/
+bool version_chains_push(struct version_chains* chains, int stripe, const void* address, uint64_t until) {
+    struct old_version* version = (struct old_version*) malloc(sizeof(struct old_version) + chains->size);
+    if (unlikely(!version)) {
+        return false;
+    }
+
+    version->address = address;
+    version->until = until;
+    word_copy(version->value, address, chains->size);
+    atomic_store_explicit(&version->next, atomic_load_explicit(&chains->heads[stripe], memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(&chains->heads[stripe], version, memory_order_release);
+    chains->lengths[stripe]++;
+    return true;
+}
+
+/** Free the versions of a stripe that no snapshot can read anymore. The caller holds the stripe's lock.
+ * A snapshot stops walking at the first version older than itself, so everything after the first version
+ * with 'until <= oldest' is unreachable; that version itself is kept as the stopping point.
+ * @param chains    Version chains
+ * @param stripe    Lock stripe
+ * @param oldest    Oldest snapshot in use
+**/
+void version_chains_reclaim(struct version_chains* chains, int stripe, uint64_t oldest) {
+    size_t length = 1;
+    struct old_version* version = atomic_load_explicit(&chains->heads[stripe], memory_order_relaxed);
+    while (version->until > oldest && atomic_load_explicit(&version->next, memory_order_relaxed) != NULL) {
+        version = atomic_load_explicit(&version->next, memory_order_relaxed);
+        length++;
+    }
+
+    struct old_version* unreachable = atomic_load_explicit(&version->next, memory_order_relaxed);
+    atomic_store_explicit(&version->next, NULL, memory_order_relaxed);
+    while (unreachable != NULL) {
+        struct old_version* next = atomic_load_explicit(&unreachable->next, memory_order_relaxed);
+        free(unreachable);
+        unreachable = next;
+    }
+    chains->lengths[stripe] = length;
+}
+
+/** Find the value a word had at a snapshot, if it was overwritten since.
+ * @param chains    Version chains
+ * @param stripe    Lock stripe of the word
+ * @param address   Address of the word
+ * @param snapshot  Snapshot (read version) of the reader
+ * @return Oldest version of the word overwritten after the snapshot, NULL if the word was not overwritten since
+**/
+const struct old_version* version_chains_find(struct version_chains* chains, int stripe, const void* address, uint64_t snapshot) {
+    const struct old_version* found = NULL;
+    const struct old_version* version = atomic_load_explicit(&chains->heads[stripe], memory_order_acquire);
+    while (version != NULL && version->until > snapshot) {
+        if (version->address == address) {
+            found = version;
+        }
+        version = atomic_load_explicit(&version->next, memory_order_acquire);
+    }
+    return found;
+}
+
+void version_chains_cleanup(struct version_chains* chains, size_t num_stripes) {
+    for (size_t i = 0; i < num_stripes; i++) {
+        struct old_version* version = atomic_load_explicit(&chains->heads[i], memory_order_relaxed);
+        while (version != NULL) {
+            struct old_version* next = atomic_load_explicit(&version->next, memory_order_relaxed);
+            free(version);
+            version = next;
+        }
+    }
+    free(chains->heads);
+    free(chains->lengths);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "word.h"
+
+#define VERSION_CHAIN_BOUND 8 // Chain length above which versions no snapshot can read are reclaimed
+
+/**
+ * @brief Value a word had until a commit overwrote it, in a chain from the newest to the oldest overwrite.
+ */
+struct old_version {
+    const void* address;
+    uint64_t until;                    // Write version of the commit that overwrote the value
+    struct old_version* _Atomic next;  // Older version (of any word of the same stripe)
+    unsigned char value[];
+};
+
+/**
+ * @brief One chain of old versions per lock stripe, only modified by the holder of the stripe's lock.
+ */
+struct version_chains {
+    struct old_version* _Atomic* heads;
+    size_t* lengths;
+    size_t size;    // Size of a word (in bytes)
+};
+
+bool version_chains_init(struct version_chains* chains, size_t num_stripes, size_t size);
+
+bool version_chains_push(struct version_chains* chains, int stripe, const void* address, uint64_t until);
+
+/** Whether the chain of a stripe grew past the bound, and should be reclaimed.
+**/
+static inline bool version_chains_over_bound(const struct version_chains* chains, int stripe) {
+    return chains->lengths[stripe] > VERSION_CHAIN_BOUND;
+}
+
+void version_chains_reclaim(struct version_chains* chains, int stripe, uint64_t oldest);
+
+const struct old_version* version_chains_find(struct version_chains* chains, int stripe, const void* address, uint64_t snapshot);
+
+void version_chains_cleanup(struct version_chains* chains, size_t num_stripes);
@@ -3,22 +3,71 @@
 #include <stdatomic.h>
 #include <emmintrin.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#define VERSIONED_SPINLOCK_LOCKED (UINT64_C(1) << 63)
+#define VERSIONED_SPINLOCK_THREAD_BITS 11 // Bits of a held lock identifying the thread of its owner (enough for any thread id)
+#define VERSIONED_SPINLOCK_HOLDER(thread, entry) (((uint64_t)(entry) << VERSIONED_SPINLOCK_THREAD_BITS) | (uint64_t)(thread))
+#define VERSIONED_SPINLOCK_THREAD(word) ((word) & ((UINT64_C(1) << VERSIONED_SPINLOCK_THREAD_BITS) - 1)) // Thread of the owner of a held lock
+#define VERSIONED_SPINLOCK_ENTRY(word) (((word) & ~VERSIONED_SPINLOCK_LOCKED) >> VERSIONED_SPINLOCK_THREAD_BITS) // Lock set entry of a held lock
+
 /**
  * @brief Versioned spinlock implementation with bounded passive backoff spin.
+ * The lock bit is the most significant bit of the word and the version its 63 other bits,
+ * so that an unlocked word with a version at most rv compares (unsigned) at most rv.
+ * While the lock is held, the other 63 bits identify its owner instead: the thread, and the entry of the owner's
+ * lock set keeping the version.
  */
 struct versioned_spinlock_t {
-    _Atomic bool lock;
-    int version;
+    _Atomic uint64_t word;
 };
 
-void versioned_spinlock_init(struct versioned_spinlock_t* lock);
+/** Initialize a lock, unlocked with version 0.
+ * @param lock Versioned spinlock
+**/
+static inline void versioned_spinlock_init(struct versioned_spinlock_t* lock) {
+    atomic_store(&lock->word, 0);
+}
 
-bool versioned_spinlock_acquire(struct versioned_spinlock_t* lock);
+/** Try to acquire the lock once, unless another owner holds it.
+ * @param lock  Versioned spinlock
+ * @param owner Identifier of the new owner (see 'VERSIONED_SPINLOCK_HOLDER'), stored in the lock while held
+ * @param word  Receives the version the lock had before we took it, or the word of the lock held by another owner
+ * @return Whether the lock was acquired
+**/
+static inline bool versioned_spinlock_try_acquire(struct versioned_spinlock_t* lock, uint64_t owner, uint64_t* word) {
+    *word = atomic_load_explicit(&lock->word, memory_order_relaxed);
+    while (!(*word & VERSIONED_SPINLOCK_LOCKED)) { // Only retry if the version changed under us
+        if (atomic_compare_exchange_weak_explicit(&lock->word, word, owner | VERSIONED_SPINLOCK_LOCKED, memory_order_acquire, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-void versioned_spinlock_release(struct versioned_spinlock_t* lock);
+/** Release a held lock, publishing a version in the same store.
+ * @param lock      Versioned spinlock
+ * @param version   New version of the lock
+**/
+static inline void versioned_spinlock_release_with_version(struct versioned_spinlock_t* lock, uint64_t version) {
+    atomic_store_explicit(&lock->word, version, memory_order_release);
+}
 
-void versioned_spinlock_update(struct versioned_spinlock_t* lock, int version);
+/** Sample the word of a lock before reading the data it protects.
+ * @param lock Versioned spinlock
+ * @return Version of the lock, or its owner with the lock bit if held
+**/
+static inline uint64_t versioned_spinlock_sample(struct versioned_spinlock_t* lock) {
+    return atomic_load_explicit(&lock->word, memory_order_acquire);
+}
 
-bool versioned_spinlock_validate(struct versioned_spinlock_t* lock, int version);
\ No newline at end of file
+/** Check after reading the data a lock protects that the lock is free and no newer than a version.
+ * @param lock      Versioned spinlock
+ * @param version   Newest version accepted
+ * @return Whether the lock is free with a version at most 'version'
+**/
+static inline bool versioned_spinlock_validate(struct versioned_spinlock_t* lock, uint64_t version) {
+    atomic_thread_fence(memory_order_acquire); // Order the data reads being validated before the lock read
+    return atomic_load_explicit(&lock->word, memory_order_relaxed) <= version; // Fails if locked or if newer
+}
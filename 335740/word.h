@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+#include "macros.h"
+
+/** Copy one word of a shared memory region. The usual word sizes get a single native load and store, without any
+ * call: at no cost at all when the size is a constant (specialized callers), behind one jump table otherwise.
+ * @param target    Address receiving the word
+ * @param source    Address of the word
+ * @param size      Size of a word (in bytes)
+**/
+static force_inline void word_copy(void* target, const void* source, size_t size) {
+    switch (size) {
+        case 1:
+            memcpy(target, source, 1);
+            break;
+        case 2:
+            memcpy(target, source, 2);
+            break;
+        case 4:
+            memcpy(target, source, 4);
+            break;
+        case 8:
+            memcpy(target, source, 8);
+            break;
+        case 16:
+            memcpy(target, source, 16);
+            break;
+        default:
+            memcpy(target, source, size);
+    }
+}
@@ -1,75 +1,293 @@
 #include "write-set.h"
 
-void write_set_init(struct write_node** first_node, struct write_node** last_node) {
-    *first_node = NULL;
-    *last_node = NULL;
+static inline size_t write_set_index_slot(uint64_t hash, size_t mask) {
+    return (hash >> 32) & mask;
 }
 
-bool write_set_add(struct write_node** first_node, struct write_node** last_node, void* target_word, const void* source_word, size_t size) {
-    if (*first_node == NULL) {
-        return write_set_add_first(first_node, last_node, target_word, source_word, size);
-    }
-    return write_set_add_next(last_node, target_word, source_word, size);
+void write_set_init(struct write_set* set) {
+    set->log = NULL;
+    set->stride = 0;
+    set->size = 0;
+    set->capacity = 0;
+    memset(set->filter, 0, sizeof(set->filter));
+    set->index = NULL;
+    set->index_mask = 0;
+    set->index_capacity = 0;
 }
 
-bool write_set_add_first(struct write_node** first_node, struct write_node** last_node, void* target_word, const void* source_word, size_t size) {
-    struct write_node* new_node;
-    if (unlikely(!write_node_create(&new_node, target_word, source_word, size))) {
+bool write_set_grow(struct write_set* set) {
+    size_t capacity = set->capacity == 0 ? WRITE_SET_INITIAL_CAPACITY : 2 * set->capacity;
+    while (capacity < (set->size + 1) * set->stride) {
+        capacity *= 2;
+    }
+
+    unsigned char* log = (unsigned char*) realloc(set->log, capacity);
+    if (unlikely(!log)) {
         return false;
     }
 
-    *first_node = new_node;
-    *last_node = new_node;
+    set->log = log;
+    set->capacity = capacity;
     return true;
 }
 
-bool write_set_add_next(struct write_node** last_node, void* target_word, const void* source_word, size_t size) {
-    struct write_node* new_node;
-    if (unlikely(!write_node_create(&new_node, target_word, source_word, size))) {
-        return false;
+bool write_set_index_insert(struct write_set* set, size_t position) {
+    if (set->index_mask == 0 || 2 * set->size > set->index_mask + 1) { // Build the index or keep its load factor at most 1/2
+        return write_set_index_grow(set); // Rehashes every entry, this one included
     }
 
-    (*last_node)->next = new_node;
-    *last_node = new_node;
+    size_t slot = write_set_index_slot(write_set_hash(write_set_entry(set, position)->address), set->index_mask);
+    while (set->index[slot] != 0) {
+        slot = (slot + 1) & set->index_mask;
+    }
+    set->index[slot] = position + 1;
     return true;
 }
 
-bool write_node_create(struct write_node** new_node, void* target_word, const void* source_word, size_t size) {
-    *new_node = (struct write_node*) malloc(sizeof(struct write_node));
-    if (unlikely(!new_node)) {
-        return false;
+bool write_set_index_grow(struct write_set* set) {
+    size_t slots = set->index_mask == 0 ? WRITE_SET_INDEX_MIN_CAPACITY : 2 * (set->index_mask + 1);
+    while (2 * set->size > slots) {
+        slots *= 2;
     }
-    (*new_node)->address = target_word;
-    (*new_node)->value = (void*) malloc(size);
-    if (unlikely(!(*new_node)->value)) {
-        return false;
+
+    if (slots > set->index_capacity) {
+        uint32_t* index = (uint32_t*) realloc(set->index, slots * sizeof(uint32_t));
+        if (unlikely(!index)) {
+            return false;
+        }
+        set->index = index;
+        set->index_capacity = slots;
     }
 
-    memcpy((*new_node)->value, source_word, size);
-    (*new_node)->next = NULL;
+    memset(set->index, 0, slots * sizeof(uint32_t));
+    set->index_mask = slots - 1;
+    for (size_t position = 0; position < set->size; position++) {
+        size_t slot = write_set_index_slot(write_set_hash(write_set_entry(set, position)->address), set->index_mask);
+        while (set->index[slot] != 0) {
+            slot = (slot + 1) & set->index_mask;
+        }
+        set->index[slot] = position + 1;
+    }
     return true;
 }
 
-void write_node_overwrite(struct write_node* node, const void* source_word, size_t size) {
-    memcpy(node->value, source_word, size);
-}
+struct write_entry* write_set_find(const struct write_set* set, const void* target_word) {
+    uint64_t hash = write_set_hash(target_word);
+    size_t bit0 = write_set_filter_bit(hash, 0);
+    size_t bit1 = write_set_filter_bit(hash, 1);
+    if (likely(!(set->filter[bit0 / 64] & (UINT64_C(1) << (bit0 % 64))) || !(set->filter[bit1 / 64] & (UINT64_C(1) << (bit1 % 64))))) {
+        return NULL; // Never written by this transaction
+    }
+
+    if (set->index_mask == 0) { // Few entries: a linear scan is cheaper than hashing
+        for (size_t position = 0; position < set->size; position++) {
+            struct write_entry* entry = write_set_entry(set, position);
+            if (entry->address == target_word) {
+                return entry;
+            }
+        }
+        return NULL;
+    }
 
-struct write_node* write_node_find(struct write_node* first_node, const void* target_word) {
-    while(first_node != NULL) {
-        if(first_node->address == target_word) {
-            return first_node;
+    size_t slot = write_set_index_slot(hash, set->index_mask);
+    while (set->index[slot] != 0) {
+        struct write_entry* entry = write_set_entry(set, set->index[slot] - 1);
+        if (entry->address == target_word) {
+            return entry;
         }
-        first_node = first_node->next;
+        slot = (slot + 1) & set->index_mask;
     }
     return NULL;
 }
 
-void write_set_cleanup(struct write_node* first_node) {
-    struct write_node* next_node;
-    while (first_node != NULL) {
-        next_node = first_node->next;
-        free(first_node->value);
-        free(first_node);
-        first_node = next_node;
+/** Tell whether some word of a range may have been written, from the Bloom filter only.
+ * @param set       Write set
+ * @param start     Address of the first word of the range
+ * @param size      Size of the range (in bytes), a multiple of the word size
+ * @param word_size Size of a word (in bytes)
+ * @return Whether some word of the range may be in the write set, false meaning that none is
+**/
+bool write_set_overlaps(const struct write_set* set, const void* start, size_t size, size_t word_size) {
+    if (set->size == 0) {
+        return false;
+    }
+
+    for (size_t offset = 0; offset < size; offset += word_size) {
+        uint64_t hash = write_set_hash((const unsigned char*) start + offset);
+        size_t bit0 = write_set_filter_bit(hash, 0);
+        size_t bit1 = write_set_filter_bit(hash, 1);
+        if ((set->filter[bit0 / 64] & (UINT64_C(1) << (bit0 % 64))) && (set->filter[bit1 / 64] & (UINT64_C(1) << (bit1 % 64)))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Sort the redo log by address, so that adjacent words can be written back together.
+ * Positions change, so the hash index is stale afterwards: only sort once no lookup follows (at commit time).
+ * @param set Write set
+**/
+void write_set_sort(struct write_set* set) {
+    size_t sorted = 1;
+    while (sorted < set->size && (uintptr_t) write_set_entry(set, sorted - 1)->address < (uintptr_t) write_set_entry(set, sorted)->address) {
+        sorted++;
+    }
+    if (sorted >= set->size) { // Already in order, e.g. a range written front to back
+        return;
+    }
+
+    if (set->size > WRITE_SET_INSERTION_SORT_THRESHOLD || set->stride > WRITE_SET_INSERTION_SORT_STRIDE) {
+        qsort(set->log, set->size, set->stride, write_set_compare);
+        return;
+    }
+
+    unsigned char moved[WRITE_SET_INSERTION_SORT_STRIDE] __attribute__((aligned(sizeof(void*))));
+    for (size_t i = sorted; i < set->size; i++) {
+        memcpy(moved, write_set_entry(set, i), set->stride);
+        uintptr_t address = (uintptr_t) ((struct write_entry*) moved)->address;
+        size_t j = i;
+        for (; j > 0 && (uintptr_t) write_set_entry(set, j - 1)->address > address; j--) {
+            memcpy(write_set_entry(set, j), write_set_entry(set, j - 1), set->stride);
+        }
+        memcpy(write_set_entry(set, j), moved, set->stride);
+    }
+}
+
+/** Get the number of entries, from a given one, that write adjacent words (in a log sorted by address).
+ * @param set       Write set, sorted by address
+ * @param position  Position of the first entry of the run
+ * @param word_size Size of a word (in bytes)
+ * @return Number of entries of the run, at least 1
+**/
+static force_inline size_t write_set_run(const struct write_set* set, size_t position, size_t word_size) {
+    size_t end = position + 1;
+    while (end < set->size && (unsigned char*) write_set_entry(set, end)->address == (unsigned char*) write_set_entry(set, end - 1)->address + word_size) {
+        end++;
+    }
+    return end - position;
+}
+
+/** Copy the values of consecutive entries next to each other.
+ * @param set       Write set
+ * @param position  Position of the first entry
+ * @param count     Number of entries
+ * @param word_size Size of a word (in bytes)
+ * @param gathered  Buffer receiving the values
+**/
+static force_inline void write_set_gather(const struct write_set* set, size_t position, size_t count, size_t word_size, unsigned char* gathered) {
+    for (size_t i = 0; i < count; i++) {
+        word_copy(gathered + i * word_size, write_set_entry(set, position + i)->value, word_size);
+    }
+}
+
+/** Store a run of adjacent words: gather their values from the log, then store them with wide stores.
+ * @param set       Write set, sorted by address
+ * @param position  Position of the first entry of the run
+ * @param count     Number of entries of the run
+ * @param word_size Size of a word (in bytes)
+ * @return Whether the run was stored with non-temporal stores
+**/
+static force_inline bool write_set_store_run(const struct write_set* set, size_t position, size_t count, size_t word_size) {
+    if (count * word_size < WRITE_SET_GATHER_MIN || word_size > WRITE_SET_GATHER_SIZE / 2) { // Too short to merge, or words already wide enough
+        for (size_t i = position; i < position + count; i++) {
+            struct write_entry* entry = write_set_entry(set, i);
+            word_copy(entry->address, entry->value, word_size);
+        }
+        return false;
+    }
+
+    unsigned char* target = (unsigned char*) write_set_entry(set, position)->address;
+    // Large runs (such as a whole array being initialized) would only evict the working set from the caches
+    bool stream = count * word_size >= WRITE_SET_STREAM_THRESHOLD && ((uintptr_t) target & 15) == 0;
+    unsigned char gathered[WRITE_SET_GATHER_SIZE] __attribute__((aligned(16)));
+    size_t per_gather = WRITE_SET_GATHER_SIZE / word_size;
+    for (size_t done = 0; done < count; ) {
+        size_t words = count - done < per_gather ? count - done : per_gather;
+        write_set_gather(set, position + done, words, word_size, gathered);
+        if (stream) {
+            write_set_stream(target + done * word_size, gathered, words * word_size);
+        }
+        else {
+            memcpy(target + done * word_size, gathered, words * word_size);
+        }
+        done += words;
+    }
+    return stream;
+}
+
+/** Store every written word to the shared memory region, each run of adjacent words at once.
+ * @param set       Write set, sorted by address
+ * @param word_size Size of a word (in bytes), a constant in every specialized copy
+**/
+static force_inline void write_set_write_back_words(const struct write_set* set, size_t word_size) {
+    bool streamed = false;
+    for (size_t position = 0; position < set->size; ) {
+        size_t count = write_set_run(set, position, word_size);
+        streamed |= write_set_store_run(set, position, count, word_size);
+        position += count;
     }
+    if (unlikely(streamed)) { // Non-temporal stores are not ordered by the releases that follow
+        _mm_sfence();
+    }
+}
+
+/** Store every written word to the shared memory region, with a copy of the loop specialized for each common word size.
+ * @param set       Write set, sorted by address
+ * @param word_size Size of a word (in bytes)
+**/
+void write_set_write_back(const struct write_set* set, size_t word_size) {
+    switch (word_size) { // Constant sizes let the compiler turn every word copy into a single load and store
+        case 1:
+            write_set_write_back_words(set, 1);
+            break;
+        case 2:
+            write_set_write_back_words(set, 2);
+            break;
+        case 4:
+            write_set_write_back_words(set, 4);
+            break;
+        case 8:
+            write_set_write_back_words(set, 8);
+            break;
+        case 16:
+            write_set_write_back_words(set, 16);
+            break;
+        default:
+            write_set_write_back_words(set, word_size);
+    }
+}
+
+/** Copy bytes with non-temporal stores, 16 at a time.
+ * @param target    Destination, 16-byte aligned
+ * @param source    Source, 16-byte aligned
+ * @param size      Number of bytes (a tail shorter than 16 bytes is copied normally)
+**/
+void write_set_stream(void* target, const void* source, size_t size) {
+    size_t offset = 0;
+    for (; offset + 16 <= size; offset += 16) {
+        _mm_stream_si128((__m128i*) ((unsigned char*) target + offset), _mm_load_si128((const __m128i*) ((const unsigned char*) source + offset)));
+    }
+    memcpy((unsigned char*) target + offset, (const unsigned char*) source + offset, size - offset);
+}
+
+int write_set_compare(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t) ((const struct write_entry*) a)->address;
+    uintptr_t y = (uintptr_t) ((const struct write_entry*) b)->address;
+    return (x > y) - (x < y);
+}
+
+void write_set_cleanup(struct write_set* set) {
+    if (set->index_mask != 0) { // Only clear the slots this transaction used
+        memset(set->index, 0, (set->index_mask + 1) * sizeof(uint32_t));
+    }
+
+    set->size = 0; // Reset the log, keeping its allocation for the next transaction
+    memset(set->filter, 0, sizeof(set->filter));
+    set->index_mask = 0;
+}
+
+void write_set_destroy(struct write_set* set) {
+    free(set->log);
+    free(set->index);
+    write_set_init(set);
 }
@@ -2,32 +2,134 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <emmintrin.h>
 
 #include "macros.h"
+#include "word.h"
+
+#define WRITE_SET_FILTER_WORDS 8        // Bloom filter size (in 64-bit words), one cache line
+#define WRITE_SET_INDEX_THRESHOLD 8     // Number of entries above which lookups go through the hash index
+#define WRITE_SET_INDEX_MIN_CAPACITY 32 // Initial number of hash index slots (power of 2)
+#define WRITE_SET_INITIAL_CAPACITY 4096 // Initial size of the redo log (in bytes)
+#define WRITE_SET_INSERTION_SORT_THRESHOLD 16 // Number of entries up to which insertion sort beats qsort
+#define WRITE_SET_INSERTION_SORT_STRIDE 64    // Largest entry (in bytes) insertion sort moves through a stack buffer
+#define WRITE_SET_GATHER_SIZE 512             // Bytes of a run of adjacent words gathered from the log before being stored at once
+#define WRITE_SET_GATHER_MIN 64               // Bytes of a run from which gathering it beats storing its words one by one
+#define WRITE_SET_STREAM_THRESHOLD (64 * 1024) // Bytes of a run from which it is stored around the caches (non-temporal stores)
 
 /**
- * @brief Holds address of a written word, value written to it, and a pointer to the next write node.
+ * @brief Redo log entry: address of a written word followed by the value written to it (of the region's word size).
  */
-struct write_node {
+struct write_entry {
     void* address;
-    void* value;
-    struct write_node* next;
+    unsigned char value[];
+};
+
+/**
+ * @brief Flat redo log in write order, indexed by address through a Bloom filter and an open-addressing hash table.
+ */
+struct write_set {
+    unsigned char* log;                          // Entries of 'stride' bytes each (kept across transactions)
+    size_t stride;                               // Size of one entry (in bytes)
+    size_t size;                                 // Number of entries in the log
+    size_t capacity;                             // Size of the log allocation (in bytes)
+    uint64_t filter[WRITE_SET_FILTER_WORDS];     // Bloom filter over the written addresses
+    uint32_t* index;                             // Hash index holding entry positions plus 1 (0 slots are empty), only used above the threshold
+    size_t index_mask;                           // Number of index slots in use minus 1 (0 while the index is not built)
+    size_t index_capacity;                       // Number of allocated index slots (kept across transactions)
 };
 
-void write_set_init(struct write_node**, struct write_node**);
+void write_set_init(struct write_set* set);
+
+bool write_set_grow(struct write_set* set); // private fn
+
+bool write_set_index_insert(struct write_set* set, size_t position); // private fn
+
+bool write_set_index_grow(struct write_set* set); // private fn
+
+/** Get an entry of the redo log.
+ * @param set      Write set
+ * @param position Position of the entry in write order
+ * @return Entry at that position
+**/
+static inline struct write_entry* write_set_entry(const struct write_set* set, size_t position) {
+    return (struct write_entry*) (set->log + position * set->stride);
+}
+
+/** Overwrite the value of an entry of the redo log.
+ * @param entry       Entry of the written word
+ * @param source_word Address of the new value (in a private region)
+ * @param size        Size of a word (in bytes)
+**/
+static force_inline void write_entry_overwrite(struct write_entry* entry, const void* source_word, size_t size) {
+    word_copy(entry->value, source_word, size);
+}
+
+/** Hash a word address, the high bits being the best mixed ones.
+ * @param address Address of the word
+ * @return Hash of the address
+**/
+static inline uint64_t write_set_hash(const void* address) {
+    return (uint64_t)(uintptr_t)address * UINT64_C(0x9E3779B97F4A7C15);
+}
+
+/** Position of the Bloom filter bit of a hash (two bits per address, taken from distinct parts of the hash).
+ * @param hash  Hash of the address
+ * @param which Which of the two bits (0 or 1)
+ * @return Position of the bit in the filter
+**/
+static inline size_t write_set_filter_bit(uint64_t hash, int which) {
+    return (hash >> (which == 0 ? 55 : 46)) & (WRITE_SET_FILTER_WORDS * 64 - 1);
+}
+
+/** Append a written word to the redo log, inlined so that the value is copied with the word size of the caller.
+ * @param set         Write set
+ * @param target_word Address of the word (in the shared region)
+ * @param source_word Address of the value (in a private region)
+ * @param size        Size of a word (in bytes)
+ * @return Whether the entry was added (false if the log or its index could not grow)
+**/
+static force_inline bool write_set_add(struct write_set* set, void* target_word, const void* source_word, size_t size) {
+    if (set->size == 0) { // The word size is fixed for the whole transaction, keep entries pointer-aligned
+        set->stride = (sizeof(struct write_entry) + size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    }
+    if (unlikely((set->size + 1) * set->stride > set->capacity)) {
+        if (unlikely(!write_set_grow(set))) {
+            return false;
+        }
+    }
+
+    struct write_entry* entry = write_set_entry(set, set->size++);
+    entry->address = target_word;
+    word_copy(entry->value, source_word, size);
+
+    uint64_t hash = write_set_hash(target_word);
+    size_t bit0 = write_set_filter_bit(hash, 0);
+    size_t bit1 = write_set_filter_bit(hash, 1);
+    set->filter[bit0 / 64] |= UINT64_C(1) << (bit0 % 64);
+    set->filter[bit1 / 64] |= UINT64_C(1) << (bit1 % 64);
+
+    if (set->index_mask != 0 || unlikely(set->size > WRITE_SET_INDEX_THRESHOLD)) { // Linear scans become too costly past the threshold
+        return write_set_index_insert(set, set->size - 1);
+    }
+    return true;
+}
+
+struct write_entry* write_set_find(const struct write_set* set, const void* target_word);
 
-bool write_set_add(struct write_node**, struct write_node**, void*, const void*, size_t);
+bool write_set_overlaps(const struct write_set* set, const void* start, size_t size, size_t word_size);
 
-bool write_set_add_first(struct write_node**, struct write_node**, void*, const void*, size_t); // private fn
+void write_set_sort(struct write_set* set);
 
-bool write_set_add_next(struct write_node**, void*, const void*, size_t); // private fn
+void write_set_write_back(const struct write_set* set, size_t word_size);
 
-bool write_node_create(struct write_node**, void*, const void*, size_t); // private fn
+void write_set_stream(void* target, const void* source, size_t size); // private fn
 
-void write_node_overwrite(struct write_node*, const void*, size_t);
+int write_set_compare(const void* a, const void* b); // private fn
 
-struct write_node* write_node_find(struct write_node*, const void*);
+void write_set_cleanup(struct write_set* set);
 
-void write_set_cleanup(struct write_node*);
+void write_set_destroy(struct write_set* set);
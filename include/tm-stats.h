@@ -0,0 +1,60 @@
+/**
+ * @file   tm-stats.h
+ * @author Edin Guso <edin.guso@epfl.ch>
+ *
+ * @section LICENSE
+ *
+ * Copyright © 2022 Edin Guso.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version. Please see https://gnu.org/licenses/gpl.html
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * @section DESCRIPTION
+ *
+ * Statistics query of the transaction manager, an extension of tm.h.
+ * Only collected when the library is built with -DTM_STATS.
+**/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tm.h>
+
+// -------------------------------------------------------------------------- //
+
+#define TM_STATS_BUCKETS 16 // Buckets of the set size histograms: 0, 1, 2-3, 4-7, ..., 2^13-2^14-1, and 2^14 or more
+
+enum tm_abort_cause {
+    TM_ABORT_READ_LOCKED,       // A read met a stripe locked by another transaction for too long
+    TM_ABORT_READ_VALIDATION,   // A read met a newer version and the snapshot could not be extended, or the word changed while read
+    TM_ABORT_WRITE_LOCKED,      // A stripe to write could not be locked (at commit time, or at write time with encounter-time locking)
+    TM_ABORT_COMMIT_VALIDATION, // The read set was no longer valid at commit time
+    TM_ABORT_NO_MEMORY,         // A set, log or old version could not grow
+    TM_NUM_ABORT_CAUSES
+};
+
+struct tm_stats_kind {
+    uint64_t commits;
+    uint64_t aborts[TM_NUM_ABORT_CAUSES];
+    uint64_t read_set_sizes[TM_STATS_BUCKETS];  // Reads recorded by the committed transactions (stripes, plus runs of stripes read at once)
+    uint64_t write_set_sizes[TM_STATS_BUCKETS]; // Words written by the committed transactions
+};
+
+struct tm_stats {
+    struct tm_stats_kind ro; // Read-only transactions
+    struct tm_stats_kind rw; // Read-write transactions
+    uint64_t validation_skips; // Read-write commits whose write version followed their read version, so that nothing was validated
+};
+
+// -------------------------------------------------------------------------- //
+
+bool tm_stats(shared_t, struct tm_stats*);
@@ -0,0 +1,33 @@
+#include "read-log.h"
+
+void read_log_init(struct read_log* log) {
+    log->log = NULL;
+    log->stride = 0;
+    log->size = 0;
+    log->capacity = 0;
+}
+
+bool read_log_grow(struct read_log* log) {
+    size_t capacity = log->capacity == 0 ? READ_LOG_INITIAL_CAPACITY : 2 * log->capacity;
+    while (capacity < (log->size + 1) * log->stride) {
+        capacity *= 2;
+    }
+
+    unsigned char* entries = (unsigned char*) realloc(log->log, capacity);
+    if (unlikely(!entries)) {
+        return false;
+    }
+
+    log->log = entries;
+    log->capacity = capacity;
+    return true;
+}
+
+void read_log_cleanup(struct read_log* log) {
+    log->size = 0; // Reset the log, keeping its allocation for the next transaction
+}
+
+void read_log_destroy(struct read_log* log) {
+    free(log->log);
+    read_log_init(log);
+}
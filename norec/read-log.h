@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "word.h"
+
+#define READ_LOG_INITIAL_CAPACITY 4096 // Initial size of the read log (in bytes)
+
+/**
+ * @brief Entry of the read log: address of a word read followed by the value seen.
+ */
+struct read_entry {
+    const void* address;
+    unsigned char value[];
+};
+
+/**
+ * @brief Flat read log in read order, validated by comparing every value seen with the word in memory.
+ */
+struct read_log {
+    unsigned char* log; // Entries of 'stride' bytes each (kept across transactions)
+    size_t stride;      // Size of one entry (in bytes)
+    size_t size;        // Number of entries in the log
+    size_t capacity;    // Size of the log allocation (in bytes)
+};
+
+void read_log_init(struct read_log* log);
+
+bool read_log_grow(struct read_log* log); // private fn
+
+/** Get an entry of the read log.
+ * @param log      Read log
+ * @param position Position of the entry in read order
+ * @return Entry at that position
+**/
+static inline struct read_entry* read_log_entry(const struct read_log* log, size_t position) {
+    return (struct read_entry*) (log->log + position * log->stride);
+}
+
+/** Read a word into a new entry of the read log.
+ * @param log   Read log
+ * @param word  Address of the word (in the shared region)
+ * @param size  Size of a word (in bytes)
+ * @return Entry holding the value seen, NULL if the log could not grow
+**/
+static force_inline struct read_entry* read_log_add(struct read_log* log, const void* word, size_t size) {
+    if (log->size == 0) { // The word size is fixed for the whole transaction, keep entries pointer-aligned
+        log->stride = (sizeof(struct read_entry) + size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    }
+    if (unlikely((log->size + 1) * log->stride > log->capacity)) {
+        if (unlikely(!read_log_grow(log))) {
+            return NULL;
+        }
+    }
+
+    struct read_entry* entry = read_log_entry(log, log->size++);
+    entry->address = word;
+    word_copy(entry->value, word, size);
+    return entry;
+}
+
+/** Drop the newest entry of the read log.
+ * @param log   Read log, not empty
+**/
+static inline void read_log_drop(struct read_log* log) {
+    log->size--;
+}
+
+void read_log_cleanup(struct read_log* log);
+
+void read_log_destroy(struct read_log* log);
@@ -0,0 +1,356 @@
+/**
+ * @file   tm.c
+ * @author Edin Guso <edin.guso@epfl.ch>
+ *
+ * @section LICENSE
+ *
+ * Copyright © 2022 Edin Guso.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version. Please see https://gnu.org/licenses/gpl.html
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * @section DESCRIPTION
+ *
+ * Software Transactional Memory (STM) implementation using
+ * the NOrec algorithm: a single global sequence lock and value-based
+ * validation, without any per-word metadata.
+**/
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE   200809L
+#ifdef __STDC_NO_ATOMICS__
+    #error Current C11 compiler does not support atomic operations
+#endif
+
+// External headers
+#include <emmintrin.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Internal headers
+#include <tm.h>
+#include "macros.h"
+#include "transaction.h"
+
+/**
+ * @brief List of dynamically allocated segments.
+ */
+struct segment_node {
+    struct segment_node* prev;
+    struct segment_node* next;
+};
+typedef struct segment_node* segment_list;
+
+/**
+ * @brief Simple Shared Memory Region (a.k.a Transactional Memory).
+ */
+struct region {
+    _Atomic uint64_t sequence;  // Global sequence lock, odd while a transaction writes back (alone on its cache line)
+    void* start;                // Start of the shared memory region (i.e., of the non-deallocable memory segment)
+    segment_list allocs;        // Shared memory segments dynamically allocated via tm_alloc within transactions
+    size_t size;                // Size of the non-deallocable memory segment (in bytes)
+    size_t align;               // Size of a word in the shared memory region (in bytes)
+    pthread_mutex_t segment_lock; // Protects the list of allocated segments
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+
+
+// Start of helper functions used to implement NOrec
+
+/** Wait for the sequence lock to be free.
+ * @param region Shared memory region
+ * @return Even value of the sequence lock
+**/
+uint64_t wait_sequence(struct region* region) {
+    uint64_t time = atomic_load_explicit(&region->sequence, memory_order_acquire);
+    while (unlikely(time & 1)) { // A transaction is writing back
+        _mm_pause();
+        time = atomic_load_explicit(&region->sequence, memory_order_acquire);
+    }
+    return time;
+}
+
+/** Check that every value read is still in memory, and move the snapshot to the time of the check.
+ * @param region        Shared memory region
+ * @param transaction   Transaction to validate
+ * @return Whether every value read is unchanged
+**/
+bool validate_read_log(struct region* region, struct transaction* transaction) {
+    while (true) {
+        uint64_t time = wait_sequence(region);
+        for (size_t i = 0; i < transaction->read_log.size; i++) {
+            struct read_entry* entry = read_log_entry(&transaction->read_log, i);
+            if (memcmp(entry->address, entry->value, region->align) != 0) {
+                return false;
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire); // Order the values compared before the sequence lock read
+        if (atomic_load_explicit(&region->sequence, memory_order_relaxed) == time) { // No write-back during the check
+            transaction->snapshot = time;
+            return true;
+        }
+    }
+}
+
+/** Read a word consistently with the snapshot of the transaction, and log the value seen.
+ * @param region        Shared memory region
+ * @param transaction   Transaction to use
+ * @param source_word   Address of the word (in the shared region)
+ * @param target_word   Address receiving the word (in a private region)
+ * @return Whether the transaction can continue
+**/
+bool read_word(struct region* region, struct transaction* transaction, const void* source_word, void* target_word) {
+    while (true) {
+        struct read_entry* entry = read_log_add(&transaction->read_log, source_word, region->align); // Copies the word into the log
+        if (unlikely(!entry)) {
+            return false;
+        }
+
+        atomic_thread_fence(memory_order_acquire); // Order the word read before the sequence lock read
+        if (likely(atomic_load_explicit(&region->sequence, memory_order_relaxed) == transaction->snapshot)) {
+            memcpy(target_word, entry->value, region->align);
+            return true;
+        }
+
+        read_log_drop(&transaction->read_log); // Read during a write-back: validate what was read before, then read again
+        if (!validate_read_log(region, transaction)) {
+            return false;
+        }
+    }
+}
+
+/** Acquire the sequence lock for the write-back, validating again every time another transaction committed first.
+ * @param region        Shared memory region
+ * @param transaction   Read-write transaction to commit
+ * @return Whether the sequence lock was acquired
+**/
+bool lock_sequence(struct region* region, struct transaction* transaction) {
+    uint64_t time = transaction->snapshot;
+    while (!atomic_compare_exchange_weak_explicit(&region->sequence, &time, transaction->snapshot + 1, memory_order_acquire, memory_order_relaxed)) {
+        if (!validate_read_log(region, transaction)) {
+            return false;
+        }
+        time = transaction->snapshot;
+    }
+    return true;
+}
+
+// End of helper functions used to implement NOrec
+
+
+
+/** Create (i.e. allocate + init) a new shared memory region, with one first non-free-able allocated segment of the requested size and alignment.
+ * @param size  Size of the first shared segment of memory to allocate (in bytes), must be a positive multiple of the alignment
+ * @param align Alignment (in bytes, must be a power of 2) that the shared memory region must support
+ * @return Opaque shared memory region handle, 'invalid_shared' on failure
+**/
+shared_t tm_create(size_t size, size_t align) {
+    struct region* region = (struct region*) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct region));
+
+    if (unlikely(!region)) {
+        return invalid_shared;
+    }
+
+    if (unlikely(posix_memalign(&(region->start), align, size) != 0)) {
+        free(region);
+        return invalid_shared;
+    }
+
+    memset(region->start, 0, size);
+    atomic_store(&region->sequence, 0);
+    pthread_mutex_init(&region->segment_lock, NULL);
+    region->allocs      = NULL;
+    region->size        = size;
+    region->align       = align;
+    return region;
+}
+
+/** Destroy (i.e. clean-up + free) a given shared memory region.
+ * @param shared Shared memory region to destroy, with no running transaction
+**/
+void tm_destroy(shared_t shared) {
+    struct region* region = (struct region*) shared;
+
+    while (region->allocs) { // Free allocated segments
+        segment_list tail = region->allocs->next;
+        free(region->allocs);
+        region->allocs = tail;
+    }
+
+    pthread_mutex_destroy(&region->segment_lock);
+    free(region->start);
+    free(region);
+}
+
+/** [thread-safe] Return the start address of the first allocated segment in the shared memory region.
+ * @param shared Shared memory region to query
+ * @return Start address of the first allocated segment
+**/
+void* tm_start(shared_t shared) {
+    return ((struct region*) shared)->start;
+}
+
+/** [thread-safe] Return the size (in bytes) of the first allocated segment of the shared memory region.
+ * @param shared Shared memory region to query
+ * @return First allocated segment size
+**/
+size_t tm_size(shared_t shared) {
+    return ((struct region*) shared)->size;
+}
+
+/** [thread-safe] Return the alignment (in bytes) of the memory accesses on the given shared memory region.
+ * @param shared Shared memory region to query
+ * @return Alignment used globally
+**/
+size_t tm_align(shared_t shared) {
+    return ((struct region*) shared)->align;
+}
+
+/** [thread-safe] Begin a new transaction on the given shared memory region.
+ * @param shared Shared memory region to start a transaction on
+ * @param is_ro  Whether the transaction is read-only
+ * @return Opaque transaction ID, 'invalid_tx' on failure
+**/
+tx_t tm_begin(shared_t shared, bool is_ro) {
+    struct region* region = (struct region*) shared;
+
+    struct transaction* transaction = transaction_acquire(); // Reuse one of the descriptors of this thread
+
+    if (unlikely(!transaction)) {
+        return invalid_tx;
+    }
+
+    transaction_init(transaction, is_ro);
+    transaction->snapshot = wait_sequence(region); // Start from a time at which no transaction is writing back
+    return (tx_t)transaction;
+}
+
+/** [thread-safe] End the given transaction.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to end
+ * @return Whether the whole transaction committed
+**/
+bool tm_end(shared_t shared, tx_t tx) {
+    struct region* region = (struct region*) shared;
+    struct transaction* transaction = (struct transaction*) tx;
+
+    if (transaction->write_set.size > 0) { // Read-only transactions are consistent with their snapshot, they always commit
+        write_set_sort(&transaction->write_set); // Before taking the sequence lock, so that sorting does not lengthen the hold time
+        if (!lock_sequence(region, transaction)) {
+            transaction_release(transaction);
+            return false;
+        }
+
+        write_set_write_back(&transaction->write_set, region->align); // Runs of adjacent words at once
+        atomic_store_explicit(&region->sequence, transaction->snapshot + 2, memory_order_release);
+    }
+
+    transaction_release(transaction);
+    return true;
+}
+
+/** [thread-safe] Read operation in the given transaction, source in the shared region and target in a private region.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param source Source start address (in the shared region)
+ * @param size   Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target Target start address (in a private region)
+ * @return Whether the whole transaction can continue
+**/
+bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* target) {
+    struct region* region = (struct region*) shared;
+    struct transaction* transaction = (struct transaction*) tx;
+
+    for (size_t offset = 0; offset < size; offset += region->align) {
+        if (!transaction->is_ro) { // Read-write transactions read their own writes
+            struct write_entry* entry = write_set_find(&transaction->write_set, source + offset);
+            if (entry != NULL) {
+                memcpy(target + offset, entry->value, region->align);
+                continue;
+            }
+        }
+
+        if (!read_word(region, transaction, source + offset, target + offset)) {
+            transaction_release(transaction);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param source Source start address (in a private region)
+ * @param size   Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target Target start address (in the shared region)
+ * @return Whether the whole transaction can continue
+**/
+bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* target) {
+    struct region* region = (struct region*) shared;
+    struct transaction* transaction = (struct transaction*) tx;
+
+    for (size_t offset = 0; offset < size; offset += region->align) {
+        struct write_entry* entry = write_set_find(&transaction->write_set, target + offset);
+        if (entry != NULL) {
+            write_entry_overwrite(entry, source + offset, region->align);
+        }
+        else if (unlikely(!write_set_add(&transaction->write_set, target + offset, source + offset, region->align))) {
+            transaction_release(transaction);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** [thread-safe] Memory allocation in the given transaction.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param size   Allocation requested size (in bytes), must be a positive multiple of the alignment
+ * @param target Pointer in private memory receiving the address of the first byte of the newly allocated, aligned segment
+ * @return Whether the whole transaction can continue (success/nomem), or not (abort_alloc)
+**/
+alloc_t tm_alloc(shared_t shared, tx_t unused(tx), size_t size, void** target) {
+    struct region* region = (struct region*) shared;
+
+    size_t align = region->align;
+    align = align < sizeof(struct segment_node*) ? sizeof(void*) : align;
+
+    struct segment_node* sn;
+    if (unlikely(posix_memalign((void**)&sn, align, sizeof(struct segment_node) + size) != 0)) {
+        return nomem_alloc;
+    }
+    sn->prev = NULL;
+
+    pthread_mutex_lock(&region->segment_lock); // Only one transaction is allowed to add allocated segments to the region at a time
+    sn->next = region->allocs;
+    if (sn->next) sn->next->prev = sn;
+    region->allocs = sn;
+    pthread_mutex_unlock(&region->segment_lock);
+
+    void* segment = (void*) ((uintptr_t) sn + sizeof(struct segment_node));
+    memset(segment, 0, size);
+    *target = segment;
+
+    return success_alloc;
+}
+
+/** [thread-safe] Memory freeing in the given transaction.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param target Address of the first byte of the previously allocated segment to deallocate
+ * @return Whether the whole transaction can continue
+**/
+bool tm_free(shared_t unused(shared), tx_t unused(tx), void* unused(segment)) {
+    return true; // No need to free anything here. All the allocated segments will be freed upon tm_destroy call
+}
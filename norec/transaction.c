@@ -0,0 +1,37 @@
+#include "transaction.h"
+
+static const struct pool_kind transaction_kind = {
+    .size = sizeof(struct transaction),
+    .create = transaction_create,
+    .destroy = transaction_destroy,
+};
+
+struct transaction* transaction_acquire(void) {
+    return (struct transaction*) transaction_pool_acquire(&transaction_kind);
+}
+
+void transaction_release(struct transaction* transaction) {
+    transaction_cleanup(transaction);
+    transaction_pool_release(&transaction->link);
+}
+
+void transaction_create(struct pool_link* link) {
+    struct transaction* transaction = (struct transaction*) link;
+    read_log_init(&transaction->read_log);
+    write_set_init(&transaction->write_set);
+}
+
+void transaction_init(struct transaction* transaction, bool is_ro) {
+    transaction->is_ro = is_ro;
+}
+
+void transaction_cleanup(struct transaction* transaction) {
+    read_log_cleanup(&transaction->read_log);
+    write_set_cleanup(&transaction->write_set);
+}
+
+void transaction_destroy(struct pool_link* link) {
+    struct transaction* transaction = (struct transaction*) link;
+    read_log_destroy(&transaction->read_log);
+    write_set_destroy(&transaction->write_set);
+}
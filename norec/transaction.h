@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "macros.h"
+#include "read-log.h"
+#include "transaction-pool.h"
+#include "write-set.h"
+
+/**
+ * @brief Holds all the reads/writes performed by a transaction.
+ */
+struct transaction {
+    struct pool_link link;      // Link in the thread's pool of descriptors (first member)
+    bool is_ro;
+    uint64_t snapshot;          // Value of the sequence lock the reads are consistent with (always even)
+    struct read_log read_log;   // Addresses read and the values seen, in read order
+    struct write_set write_set; // Redo log of the written words
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct transaction* transaction_acquire(void);
+
+void transaction_release(struct transaction* transaction);
+
+void transaction_init(struct transaction* transaction, bool is_ro);
+
+void transaction_cleanup(struct transaction* transaction);
+
+void transaction_create(struct pool_link* link); // private fn
+
+void transaction_destroy(struct pool_link* link); // private fn
@@ -0,0 +1,197 @@
+/**
+ * Concurrent transfers between accounts, checking that every snapshot sums
+ * to the initial total. A part of the money sits in a vault segment that
+ * transactions keep moving to newly allocated segments, freeing the old one,
+ * so that allocation, freeing and reclamation run under contention too.
+ *
+ * Usage: bank <library.so> [threads] [transactions per thread]
+**/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#define BANK_ACCOUNTS 64        // Accounts of the first segment, one word each
+#define BANK_BALANCE 100        // Initial balance of every account and of the vault
+#define BANK_VAULT_WORDS 8      // Size of a vault segment (in words), its balance being the first one
+
+/**
+ * @brief First segment: accounts, then the address of the current vault segment.
+ */
+struct bank {
+    uint64_t accounts[BANK_ACCOUNTS];
+    uint64_t* vault;
+};
+
+static struct tm_library tm;
+static shared_t region;
+static long transactions;
+static _Atomic long failures = 0;
+
+/** Move money between two accounts, reading a run of accounts at once when they are close.
+ * @param bank  First segment
+ * @param seed  Generator state of the thread
+ * @return Whether the transaction committed
+**/
+static bool transfer(struct bank* bank, uint64_t* seed) {
+    size_t from = test_random(seed) % BANK_ACCOUNTS;
+    size_t to = (from + 1 + test_random(seed) % 4) % BANK_ACCOUNTS; // Mostly neighbours
+    tx_t tx = tm.begin(region, false);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    uint64_t balances[2];
+    if (!tm.read(region, tx, &bank->accounts[from], sizeof(uint64_t), &balances[0])
+            || !tm.read(region, tx, &bank->accounts[to], sizeof(uint64_t), &balances[1])) {
+        return false;
+    }
+    if (test_random(seed) % 8 == 0) { // Let other threads run in between, even on a single core
+        sched_yield();
+    }
+    uint64_t amount = balances[0] > 0 ? test_random(seed) % (balances[0] + 1) : 0;
+    balances[0] -= amount;
+    balances[1] += amount;
+    return tm.write(region, tx, &balances[0], sizeof(uint64_t), &bank->accounts[from])
+        && tm.write(region, tx, &balances[1], sizeof(uint64_t), &bank->accounts[to])
+        && tm.end(region, tx);
+}
+
+/** Move the vault to a new segment, freeing the old one.
+ * @param bank  First segment
+ * @return Whether the transaction committed
+**/
+static bool move_vault(struct bank* bank) {
+    tx_t tx = tm.begin(region, false);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    uint64_t* vault;
+    uint64_t contents[BANK_VAULT_WORDS];
+    if (!tm.read(region, tx, &bank->vault, sizeof(uint64_t*), &vault)
+            || !tm.read(region, tx, vault, sizeof(contents), contents)) {
+        return false;
+    }
+    sched_yield(); // While the old vault is still reachable
+    void* moved;
+    alloc_t result = tm.alloc(region, tx, sizeof(contents), &moved);
+    if (result == abort_alloc) {
+        return false;
+    }
+    if (result == nomem_alloc) {
+        fprintf(stderr, "bank: tm_alloc ran out of memory\n");
+        failures++;
+        return tm.end(region, tx);
+    }
+    contents[1]++; // Number of moves
+    return tm.write(region, tx, contents, sizeof(contents), moved)
+        && tm.write(region, tx, &moved, sizeof(uint64_t*), &bank->vault)
+        && tm.free(region, tx, vault)
+        && tm.end(region, tx);
+}
+
+/** Sum every account and the vault in one read-only transaction, reading the accounts as one range.
+ * @param bank  First segment
+ * @param total Sum of the snapshot
+ * @return Whether the transaction committed
+**/
+static bool audit(struct bank* bank, uint64_t* total) {
+    tx_t tx = tm.begin(region, true);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    uint64_t accounts[BANK_ACCOUNTS];
+    uint64_t* vault;
+    uint64_t balance;
+    if (!tm.read(region, tx, bank->accounts, sizeof(accounts), accounts)
+            || !tm.read(region, tx, &bank->vault, sizeof(uint64_t*), &vault)
+            || !tm.read(region, tx, vault, sizeof(uint64_t), &balance)
+            || !tm.end(region, tx)) {
+        return false;
+    }
+    *total = balance;
+    for (size_t i = 0; i < BANK_ACCOUNTS; i++) {
+        *total += accounts[i];
+    }
+    return true;
+}
+
+static void* run(void* argument) {
+    uint64_t seed = (uintptr_t) argument * 0x9E3779B97F4A7C15ull + 1;
+    struct bank* bank = (struct bank*) tm.start(region);
+    for (long i = 0; i < transactions; i++) {
+        uint64_t kind = test_random(&seed) % 100;
+        if (kind < 2) {
+            while (!move_vault(bank));
+        }
+        else if (kind < 20) {
+            uint64_t total;
+            while (!audit(bank, &total));
+            if (total != (BANK_ACCOUNTS + 1) * BANK_BALANCE) {
+                fprintf(stderr, "bank: audit saw %lu instead of %lu\n", (unsigned long) total, (unsigned long) (BANK_ACCOUNTS + 1) * BANK_BALANCE);
+                failures++;
+            }
+        }
+        else {
+            while (!transfer(bank, &seed));
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <library.so> [threads] [transactions per thread]\n", argv[0]);
+        return 2;
+    }
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    transactions = argc > 3 ? atol(argv[3]) : 2000;
+    if (!tm_library_open(&tm, argv[1])) {
+        return 2;
+    }
+
+    region = tm.create(sizeof(struct bank), sizeof(uint64_t));
+    if (region == invalid_shared) {
+        fprintf(stderr, "bank: tm_create failed\n");
+        return 1;
+    }
+    struct bank* bank = (struct bank*) tm.start(region);
+    bool initialized = false;
+    while (!initialized) {
+        tx_t tx = tm.begin(region, false);
+        uint64_t balances[BANK_ACCOUNTS];
+        uint64_t contents[BANK_VAULT_WORDS] = { BANK_BALANCE };
+        void* vault;
+        for (size_t i = 0; i < BANK_ACCOUNTS; i++) {
+            balances[i] = BANK_BALANCE;
+        }
+        initialized = tm.write(region, tx, balances, sizeof(balances), bank->accounts)
+            && tm.alloc(region, tx, sizeof(contents), &vault) == success_alloc
+            && tm.write(region, tx, contents, sizeof(contents), vault)
+            && tm.write(region, tx, &vault, sizeof(uint64_t*), &bank->vault)
+            && tm.end(region, tx);
+    }
+
+    pthread_t* workers = (pthread_t*) malloc((size_t) threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, run, (void*) (uintptr_t) (i + 1));
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    uint64_t total;
+    while (!audit(bank, &total));
+    if (total != (BANK_ACCOUNTS + 1) * BANK_BALANCE) {
+        fprintf(stderr, "bank: final total %lu instead of %lu\n", (unsigned long) total, (unsigned long) (BANK_ACCOUNTS + 1) * BANK_BALANCE);
+        failures++;
+    }
+    tm.destroy(region);
+    printf("bank: %d threads, %ld transactions each, %ld failures\n", threads, transactions, (long) failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <tm.h>
+
+/**
+ * @brief Functions of an STM library, loaded at run time as the grading harness does.
+ */
+struct tm_library {
+    void* handle;
+    shared_t (*create)(size_t, size_t);
+    void (*destroy)(shared_t);
+    void* (*start)(shared_t);
+    tx_t (*begin)(shared_t, bool);
+    bool (*end)(shared_t, tx_t);
+    bool (*read)(shared_t, tx_t, void const*, size_t, void*);
+    bool (*write)(shared_t, tx_t, void const*, size_t, void*);
+    alloc_t (*alloc)(shared_t, tx_t, size_t, void**);
+    bool (*free)(shared_t, tx_t, void*);
+};
+
+/** Load an STM library and resolve its functions.
+ * @param library   Library to fill
+ * @param path      Path of the shared object
+ * @return Whether every function was found
+**/
+static inline bool tm_library_open(struct tm_library* library, const char* path) {
+    library->handle = dlopen(path, RTLD_NOW);
+    if (library->handle == NULL) {
+        fprintf(stderr, "%s\n", dlerror());
+        return false;
+    }
+    *(void**) &library->create = dlsym(library->handle, "tm_create");
+    *(void**) &library->destroy = dlsym(library->handle, "tm_destroy");
+    *(void**) &library->start = dlsym(library->handle, "tm_start");
+    *(void**) &library->begin = dlsym(library->handle, "tm_begin");
+    *(void**) &library->end = dlsym(library->handle, "tm_end");
+    *(void**) &library->read = dlsym(library->handle, "tm_read");
+    *(void**) &library->write = dlsym(library->handle, "tm_write");
+    *(void**) &library->alloc = dlsym(library->handle, "tm_alloc");
+    *(void**) &library->free = dlsym(library->handle, "tm_free");
+    if (!library->create || !library->destroy || !library->start || !library->begin || !library->end
+            || !library->read || !library->write || !library->alloc || !library->free) {
+        fprintf(stderr, "%s: missing STM functions\n", path);
+        return false;
+    }
+    return true;
+}
+
+/** Draw a pseudo-random number (xorshift), each thread keeping its own state.
+ * @param state State of the generator, not 0
+ * @return Next number
+**/
+static inline uint64_t test_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
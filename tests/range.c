@@ -0,0 +1,153 @@
+/**
+ * Concurrent range reads and writes over one array, every writer setting all
+ * its words to one new value in several out-of-order pieces. Any range a
+ * transaction reads must then hold a single value, the one of the first word.
+ * Writers also read back a range overlapping their own writes, and some
+ * readers start their transaction well before their range read, so that
+ * the writers commit in between and the range read extends the snapshot.
+ *
+ * Usage: range <library.so> [threads] [transactions per thread]
+**/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#define RANGE_WORDS 64          // Words of the array, at the start of the first segment
+#define RANGE_MAX_OFFSET 16     // Ranges start within the first words of the array
+#define RANGE_UNWRITTEN RANGE_WORDS // Word past the array, never written, read first by the late readers
+
+static struct tm_library tm;
+static shared_t region;
+static long transactions;
+static _Atomic long failures = 0;
+
+/** Set every word of the array to the successor of the first one, writing the range [offset, offset + length) first.
+ * @param array     Array, in the first segment
+ * @param offset    First word of the first piece written
+ * @param length    Number of words of the first piece written
+ * @return Whether the transaction committed
+**/
+static bool increment(uint64_t* array, size_t offset, size_t length) {
+    tx_t tx = tm.begin(region, false);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    uint64_t value;
+    if (!tm.read(region, tx, array, sizeof(uint64_t), &value)) {
+        return false;
+    }
+    uint64_t values[RANGE_WORDS];
+    for (size_t i = 0; i < RANGE_WORDS; i++) {
+        values[i] = value + 1;
+    }
+    size_t rest = RANGE_WORDS - offset - length;
+    if (!tm.write(region, tx, values, length * sizeof(uint64_t), array + offset)
+            || (offset > 0 && !tm.write(region, tx, values, offset * sizeof(uint64_t), array))
+            || (rest > 0 && !tm.write(region, tx, values, rest * sizeof(uint64_t), array + offset + length))) {
+        return false;
+    }
+
+    uint64_t written[RANGE_WORDS];
+    if (!tm.read(region, tx, array, sizeof(written), written)) { // Every word from the write set, or written in place
+        return false;
+    }
+    for (size_t i = 0; i < RANGE_WORDS; i++) {
+        if (written[i] != value + 1) {
+            fprintf(stderr, "range: word %zu read back %lu instead of %lu\n", i, (unsigned long) written[i], (unsigned long) value + 1);
+            failures++;
+            break;
+        }
+    }
+    return tm.end(region, tx);
+}
+
+/** Read the range [offset, offset + length), then the first word, checking that they are all equal after commit.
+ * @param array     Array, in the first segment
+ * @param offset    First word of the range
+ * @param length    Number of words of the range
+ * @param is_ro     Whether to read in a read-only transaction
+ * @param late      Whether to read another word first and let the writers run before reading the range
+ * @return Whether the transaction committed
+**/
+static bool check(uint64_t* array, size_t offset, size_t length, bool is_ro, bool late) {
+    tx_t tx = tm.begin(region, is_ro);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    uint64_t values[RANGE_WORDS];
+    uint64_t first;
+    if (late) { // The snapshot is then older than the range, which must extend it while writers may commit again
+        uint64_t unwritten;
+        if (!tm.read(region, tx, array + RANGE_UNWRITTEN, sizeof(uint64_t), &unwritten)) {
+            return false;
+        }
+        sched_yield();
+    }
+    if (!tm.read(region, tx, array + offset, length * sizeof(uint64_t), values)
+            || !tm.read(region, tx, array, sizeof(uint64_t), &first)
+            || !tm.end(region, tx)) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (values[i] != first) {
+            fprintf(stderr, "range: word %zu was %lu while the first one was %lu\n", offset + i, (unsigned long) values[i], (unsigned long) first);
+            failures++;
+            break;
+        }
+    }
+    return true;
+}
+
+static void* run(void* argument) {
+    uint64_t seed = (uintptr_t) argument * 0x9E3779B97F4A7C15ull + 1;
+    uint64_t* array = (uint64_t*) tm.start(region);
+    for (long i = 0; i < transactions; i++) {
+        size_t offset = test_random(&seed) % RANGE_MAX_OFFSET;
+        size_t length = 1 + test_random(&seed) % (RANGE_WORDS - offset);
+        if (i % 3 == 0) {
+            while (!increment(array, offset, length));
+        }
+        else {
+            while (!check(array, offset, length, i % 2 == 0, i % 3 == 1));
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <library.so> [threads] [transactions per thread]\n", argv[0]);
+        return 2;
+    }
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    transactions = argc > 3 ? atol(argv[3]) : 5000;
+    if (!tm_library_open(&tm, argv[1])) {
+        return 2;
+    }
+
+    region = tm.create(RANGE_WORDS * sizeof(uint64_t) * 4, sizeof(uint64_t)); // The first segment starts zeroed
+    if (region == invalid_shared) {
+        fprintf(stderr, "range: tm_create failed\n");
+        return 1;
+    }
+    pthread_t* workers = (pthread_t*) malloc((size_t) threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, run, (void*) (uintptr_t) (i + 1));
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    uint64_t* array = (uint64_t*) tm.start(region);
+    while (!check(array, 0, RANGE_WORDS, true, false));
+    tm.destroy(region);
+    printf("range: %d threads, %ld transactions each, %ld failures\n", threads, transactions, (long) failures);
+    return failures == 0 ? 0 : 1;
+}
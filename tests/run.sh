@@ -0,0 +1,46 @@
+#!/bin/sh
+# Run every test against the libraries, the TL2 one in every combination of
+# engine, clock scheme and lock layout, plus the optional features.
+# Usage: run.sh [library.so ...] (by default ../335740.so and ../norec.so)
+
+cd "$(dirname "$0")" || exit 2
+LIBRARIES=${*:-"../335740.so ../norec.so"}
+FAILED=0
+
+# Run every test under the given environment
+check() {
+    for test in ./bank ./range ./write-back; do
+        if ! env "$@" "$test" "$library" >/dev/null; then
+            echo "FAIL: $* $test $library"
+            FAILED=$((FAILED + 1))
+        fi
+    done
+}
+
+for library in $LIBRARIES; do
+    case $library in
+        *335740.so)
+            for engine in tl2 mv etl; do
+                for clock in gv1 gv4 gv5 gv6 tlc; do
+                    for layout in table word line; do
+                        check TM_ENGINE=$engine TM_CLOCK=$clock TM_LOCK_LAYOUT=$layout
+                    done
+                done
+                check TM_ENGINE=$engine TM_RECLAIM=0
+                check TM_ENGINE=$engine TM_IRREVOCABLE_AFTER=2
+                for policy in backoff karma timestamp polka; do
+                    check TM_ENGINE=$engine TM_CONTENTION=$policy
+                done
+            done
+            ;;
+        *)
+            check TM_UNUSED=1
+            ;;
+    esac
+done
+
+if [ "$FAILED" -ne 0 ]; then
+    echo "$FAILED failed"
+    exit 1
+fi
+echo "All passed"
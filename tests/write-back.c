@@ -0,0 +1,123 @@
+/**
+ * Single-threaded write-back check for every word size from 8 to 512 bytes:
+ * one transaction fills a large first segment, then transactions write
+ * scattered, adjacent and overlapping runs of words, and a final read of
+ * the whole segment must match a private copy written alongside.
+ *
+ * Usage: write-back <library.so> [transactions per word size]
+**/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define WRITE_BACK_SIZE (1 << 20)       // Size of the first segment (in bytes)
+#define WRITE_BACK_MIN_ALIGN 8          // Smallest word size checked (in bytes)
+#define WRITE_BACK_MAX_ALIGN 512        // Largest word size checked (in bytes)
+#define WRITE_BACK_MAX_RUNS 40          // Runs of words written by a transaction at most
+#define WRITE_BACK_MAX_RUN_WORDS 3      // Words of a run at most
+
+static struct tm_library tm;
+
+/** Write one transaction of random runs of words, to the region and to the private copy.
+ * @param region    Shared memory region
+ * @param copy      Private copy of the first segment
+ * @param align     Word size of the region (in bytes)
+ * @param seed      Generator state
+ * @return Whether the transaction committed
+**/
+static bool write_runs(shared_t region, unsigned char* copy, size_t align, uint64_t* seed) {
+    unsigned char* start = (unsigned char*) tm.start(region);
+    size_t words = WRITE_BACK_SIZE / align;
+    tx_t tx = tm.begin(region, false);
+    if (tx == invalid_tx) {
+        return false;
+    }
+    size_t runs = 1 + test_random(seed) % WRITE_BACK_MAX_RUNS;
+    size_t word = test_random(seed) % words;
+    for (size_t i = 0; i < runs; i++) {
+        if (i == 0 || test_random(seed) % 2 == 0) { // Otherwise right after the previous run, or overlapping it
+            word = test_random(seed) % words;
+        }
+        size_t length = 1 + test_random(seed) % WRITE_BACK_MAX_RUN_WORDS;
+        if (word + length > words) {
+            length = words - word;
+        }
+        for (size_t byte = word * align; byte < (word + length) * align; byte++) {
+            copy[byte] = (unsigned char) test_random(seed);
+        }
+        if (!tm.write(region, tx, copy + word * align, length * align, start + word * align)) {
+            return false;
+        }
+        word = (word + 1) % words;
+    }
+    return tm.end(region, tx);
+}
+
+/** Check the write-back of one word size.
+ * @param align         Word size of the region (in bytes)
+ * @param transactions  Number of transactions writing runs of words
+ * @return Number of failures
+**/
+static long check_align(size_t align, long transactions) {
+    shared_t region = tm.create(WRITE_BACK_SIZE, align);
+    if (region == invalid_shared) {
+        fprintf(stderr, "write-back: tm_create failed for words of %zu bytes\n", align);
+        return 1;
+    }
+    unsigned char* start = (unsigned char*) tm.start(region);
+    unsigned char* copy = (unsigned char*) malloc(WRITE_BACK_SIZE);
+    unsigned char* result = (unsigned char*) malloc(WRITE_BACK_SIZE);
+    for (size_t i = 0; i < WRITE_BACK_SIZE; i++) {
+        copy[i] = (unsigned char) (i * 7 + align);
+    }
+
+    long failures = 0;
+    tx_t tx = tm.begin(region, false);
+    if (!tm.write(region, tx, copy, WRITE_BACK_SIZE, start) || !tm.end(region, tx)) { // Alone, so it must commit
+        fprintf(stderr, "write-back: filling the segment aborted for words of %zu bytes\n", align);
+        failures++;
+    }
+    uint64_t seed = align;
+    for (long i = 0; i < transactions; i++) {
+        if (!write_runs(region, copy, align, &seed)) {
+            fprintf(stderr, "write-back: a transaction aborted alone for words of %zu bytes\n", align);
+            failures++;
+        }
+    }
+
+    tx = tm.begin(region, true);
+    if (!tm.read(region, tx, start, WRITE_BACK_SIZE, result) || !tm.end(region, tx)) {
+        fprintf(stderr, "write-back: the final read aborted for words of %zu bytes\n", align);
+        failures++;
+    }
+    else if (memcmp(result, copy, WRITE_BACK_SIZE) != 0) {
+        fprintf(stderr, "write-back: the segment does not match the writes for words of %zu bytes\n", align);
+        failures++;
+    }
+    tm.destroy(region);
+    free(copy);
+    free(result);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <library.so> [transactions per word size]\n", argv[0]);
+        return 2;
+    }
+    long transactions = argc > 2 ? atol(argv[2]) : 200;
+    if (!tm_library_open(&tm, argv[1])) {
+        return 2;
+    }
+
+    long failures = 0;
+    for (size_t align = WRITE_BACK_MIN_ALIGN; align <= WRITE_BACK_MAX_ALIGN; align *= 2) {
+        failures += check_align(align, transactions);
+    }
+    printf("write-back: %ld transactions per word size, %ld failures\n", transactions, failures);
+    return failures == 0 ? 0 : 1;
+}